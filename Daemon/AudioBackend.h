@@ -18,6 +18,8 @@
 
 class IAudioBackend {
 public:
+	virtual ~IAudioBackend() {}
+
 	virtual void setCallback(IAudioCallback* callback, int id = 0) = 0;
 	virtual bool open() = 0;
 	virtual void close() = 0;
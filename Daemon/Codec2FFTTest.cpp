@@ -0,0 +1,168 @@
+/*
+ *   Copyright (C) 2022 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include "codec2/kiss_fft.h"
+#include "TestUtils.h"
+
+#include <algorithm>
+#include <complex>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+
+const unsigned int RUNS = 200U;
+
+// The largest error relative to the largest output, float rounding over
+// nine stages is about 1e-7
+const double LIMIT = 1.0E-5;
+
+// The transforms by their definition in double precision, unscaled in both
+// directions as kiss_fft is
+static void dft(const std::complex<double>* in, std::complex<double>* out, unsigned int n, bool inverse)
+{
+	const double sign = inverse ? 1.0 : -1.0;
+
+	std::vector<std::complex<double>> w(n);
+	for (unsigned int i = 0U; i < n; i++)
+		w[i] = std::polar(1.0, sign * 2.0 * M_PI * double(i) / double(n));
+
+	for (unsigned int k = 0U; k < n; k++) {
+		std::complex<double> sum = 0.0;
+		for (unsigned int i = 0U; i < n; i++)
+			sum += in[i] * w[(k * i) % n];
+		out[k] = sum;
+	}
+}
+
+static double error(const std::complex<float>* out, const std::complex<double>* ref, unsigned int n)
+{
+	double maxErr = 0.0;
+	double maxRef = 0.0;
+
+	for (unsigned int i = 0U; i < n; i++) {
+		maxErr = std::max(maxErr, std::abs(std::complex<double>(out[i]) - ref[i]));
+		maxRef = std::max(maxRef, std::abs(ref[i]));
+	}
+
+	return maxErr / maxRef;
+}
+
+static bool checkComplex(unsigned int n, bool inverse)
+{
+	CKissFFT kiss;
+	FFT_STATE state;
+	kiss.fft_alloc(state, n, inverse);
+
+	std::vector<std::complex<float>>  in(n), out(n);
+	std::vector<std::complex<double>> in2(n), ref(n);
+
+	unsigned int failures = 0U;
+
+	for (unsigned int run = 0U; run < RUNS; run++) {
+		for (unsigned int i = 0U; i < n; i++) {
+			in[i]  = std::complex<float>(CTestUtils::randomFloat(-1.0F, 1.0F), CTestUtils::randomFloat(-1.0F, 1.0F));
+			in2[i] = in[i];
+		}
+
+		kiss.fft(state, in.data(), out.data());
+		dft(in2.data(), ref.data(), n, inverse);
+
+		if (error(out.data(), ref.data(), n) > LIMIT)
+			failures++;
+	}
+
+	char name[40U];
+	::sprintf(name, "%s %u", inverse ? "inverse" : "forward", n);
+
+	return CTestUtils::report(name, RUNS, failures);
+}
+
+// The real forward transform gives n / 2 + 1 bins, the real inverse takes
+// them and gives n samples
+static bool checkReal(unsigned int n, bool inverse)
+{
+	CKissFFT kiss;
+	FFTR_STATE state;
+	kiss.fftr_alloc(state, n, inverse);
+
+	std::vector<float> time(n);
+	std::vector<std::complex<float>>  freq(n / 2U + 1U), out(n);
+	std::vector<std::complex<double>> in2(n), ref(n);
+
+	unsigned int failures = 0U;
+
+	for (unsigned int run = 0U; run < RUNS; run++) {
+		double err;
+
+		if (inverse) {
+			// A random spectrum of a real signal, the DC and Nyquist bins are real
+			for (unsigned int k = 0U; k <= n / 2U; k++)
+				freq[k] = std::complex<float>(CTestUtils::randomFloat(-1.0F, 1.0F), CTestUtils::randomFloat(-1.0F, 1.0F));
+			freq[0U].imag(0.0F);
+			freq[n / 2U].imag(0.0F);
+
+			for (unsigned int k = 0U; k <= n / 2U; k++) {
+				in2[k] = freq[k];
+				if (k > 0U && k < n / 2U)
+					in2[n - k] = std::conj(in2[k]);
+			}
+
+			kiss.fftri(state, freq.data(), time.data());
+			dft(in2.data(), ref.data(), n, true);
+
+			for (unsigned int i = 0U; i < n; i++)
+				out[i] = time[i];
+
+			err = error(out.data(), ref.data(), n);
+		} else {
+			for (unsigned int i = 0U; i < n; i++) {
+				time[i] = CTestUtils::randomFloat(-1.0F, 1.0F);
+				in2[i]  = time[i];
+			}
+
+			kiss.fftr(state, time.data(), freq.data());
+			dft(in2.data(), ref.data(), n, false);
+
+			err = error(freq.data(), ref.data(), n / 2U + 1U);
+		}
+
+		if (err > LIMIT)
+			failures++;
+	}
+
+	char name[40U];
+	::sprintf(name, "%s %u", inverse ? "real inverse" : "real forward", n);
+
+	return CTestUtils::report(name, RUNS, failures);
+}
+
+int main(int argc, char** argv)
+{
+	CTestUtils::seed(argc, argv);
+
+	bool ok = true;
+	ok &= checkComplex(512U, false);
+	ok &= checkComplex(512U, true);
+	ok &= checkComplex(256U, false);
+	ok &= checkComplex(256U, true);
+	ok &= checkReal(512U, false);
+	ok &= checkReal(512U, true);
+
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,178 @@
+/*
+ *   Copyright (C) 2022 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include "codec2/qbase.h"
+#include "TestUtils.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+// The codebook searches are protected, this makes them callable
+class CVQTest : public CQbase {
+public:
+	using CQbase::quantise;
+	using CQbase::find_nearest_weighted;
+};
+
+// The scalar loops from CQbase::quantise() and find_nearest_weighted(),
+// kept here as the reference for the SSE2/NEON vq_search()
+static long quantiseScalar(const float* cb, const float* vec, const float* w, int k, int m, float* se)
+{
+	long besti = 0;
+	float beste = 1E32;
+	for (long j = 0; j < m; j++) {
+		float e = 0.0;
+		for (int i = 0; i < k; i++) {
+			float diff = cb[j * k + i] - vec[i];
+			e += (diff * w[i] * diff * w[i]);
+		}
+		if (e < beste) {
+			beste = e;
+			besti = j;
+		}
+	}
+
+	*se += beste;
+
+	return besti;
+}
+
+static int findNearestScalar(const float* codebook, int nb_entries, const float* x, const float* w, int ndim)
+{
+	float min_dist = 1e15;
+	int nearest = 0;
+
+	for (int i = 0; i < nb_entries; i++) {
+		float dist = 0;
+		for (int j = 0; j < ndim; j++)
+			dist += w[j] * (x[j] - codebook[i * ndim + j]) * (x[j] - codebook[i * ndim + j]);
+		if (dist < min_dist) {
+			min_dist = dist;
+			nearest = i;
+		}
+	}
+
+	return nearest;
+}
+
+// Each entry, each entry nudged, the midpoints between neighbouring entries
+// which can tie, and random vectors over a range a little wider than the
+// codebook
+static unsigned int makeVectors(const struct lsp_codebook& cb, unsigned int n, float* vectors)
+{
+	const int k = cb.k;
+	const int m = cb.m;
+
+	float min = cb.cb[0];
+	float max = cb.cb[0];
+	for (int i = 0; i < k * m; i++) {
+		if (cb.cb[i] < min)
+			min = cb.cb[i];
+		if (cb.cb[i] > max)
+			max = cb.cb[i];
+	}
+
+	float margin = (max - min) * 0.1F + 1.0F;
+
+	unsigned int count = 0U;
+	for (int j = 0; j < m; j++) {
+		for (int i = 0; i < k; i++) {
+			vectors[(count + 0U) * k + i] = cb.cb[j * k + i];
+			vectors[(count + 1U) * k + i] = cb.cb[j * k + i] + CTestUtils::randomFloat(-0.01F, 0.01F) * margin;
+			vectors[(count + 2U) * k + i] = (cb.cb[j * k + i] + cb.cb[((j + 1) % m) * k + i]) * 0.5F;
+		}
+		count += 3U;
+	}
+
+	while (count < n) {
+		for (int i = 0; i < k; i++)
+			vectors[count * k + i] = CTestUtils::randomFloat(min - margin, max + margin);
+		count++;
+	}
+
+	return count;
+}
+
+static unsigned int check(const char* name, const struct lsp_codebook& cb, bool squared, unsigned int& total)
+{
+	const unsigned int VECTORS = 4000U;
+
+	CVQTest vq;
+
+	float* vectors = new float[(VECTORS + cb.m * 3U) * cb.k];
+	unsigned int n = makeVectors(cb, VECTORS + cb.m * 3U, vectors);
+
+	unsigned int failures = 0U;
+
+	for (unsigned int v = 0U; v < n; v++) {
+		float* x = vectors + v * cb.k;
+
+		// Unit weights as used by the LSP quantisers, then random ones, the
+		// codebooks are at most two dimensional
+		float w[2U] = {1.0F, 1.0F};
+		if ((v % 2U) == 1U) {
+			for (int i = 0; i < cb.k; i++)
+				w[i] = CTestUtils::randomFloat(0.01F, 100.0F);
+		}
+
+		long i1, i2;
+		float se1 = 0.0F, se2 = 0.0F;
+		if (squared) {
+			i1 = vq.quantise(cb.cb, x, w, cb.k, cb.m, &se1);
+			i2 = quantiseScalar(cb.cb, x, w, cb.k, cb.m, &se2);
+		} else {
+			i1 = vq.find_nearest_weighted(cb.cb, cb.m, x, w, cb.k);
+			i2 = findNearestScalar(cb.cb, cb.m, x, w, cb.k);
+		}
+
+		if (i1 != i2 || ::memcmp(&se1, &se2, sizeof(float)) != 0) {
+			if (failures == 0U)
+				::fprintf(stderr, "Codec2VQTest: %s vector %u gave index %ld error %g, the scalar search %ld error %g\n", name, v, i1, se1, i2, se2);
+			failures++;
+		}
+	}
+
+	delete[] vectors;
+
+	total += n;
+
+	return failures;
+}
+
+int main(int argc, char** argv)
+{
+	CTestUtils::seed(argc, argv);
+
+#if !defined(__SSE2__) && !defined(__ARM_NEON)
+	::fprintf(stdout, "Codec2VQTest: no SIMD search in this build, comparing the scalar search with itself\n");
+#endif
+
+	unsigned int failures = 0U;
+	unsigned int vectors  = 0U;
+
+	for (unsigned int i = 0U; lsp_cb[i].cb != NULL; i++)
+		failures += check("lsp_cb", lsp_cb[i], true, vectors);
+
+	for (unsigned int i = 0U; lsp_cbd[i].cb != NULL; i++)
+		failures += check("lsp_cbd", lsp_cbd[i], true, vectors);
+
+	failures += check("ge_cb", ge_cb[0U], false, vectors);
+
+	return CTestUtils::report("codebook search", vectors, failures) ? 0 : 1;
+}
@@ -37,7 +37,8 @@ enum SECTION {
 	SECTION_GPIO,
 	SECTION_HAMLIB,
 	SECTION_GPSD,
-	SECTION_CONTROL
+	SECTION_CONTROL,
+	SECTION_THREADS
 };
 
 CConf::CConf(const std::string& file) :
@@ -52,6 +53,14 @@ m_audioInputDevice(),
 m_audioOutputDevice(),
 m_audioMicGain(100U),
 m_audioVolume(100U),
+m_audioResampler("Polyphase"),
+m_audioNativeRate(false),
+m_audioMMAP(false),
+m_audioChannel("Mix"),
+m_audioJACKQuantum(256U),
+m_audioJitterTarget(0U),
+m_audioConcealBER(0U),
+m_audioConcealHang(0U),
 m_modemPort(),
 m_modemSpeed(460800U),
 m_modemRXInvert(false),
@@ -68,6 +77,9 @@ m_modemTXLevel(50.0F),
 m_modemRSSIMappingFile(),
 m_modemTrace(false),
 m_modemDebug(false),
+m_modemLoopbackDelay(0U),
+m_modemLoopbackBER(0.0F),
+m_modemLoopbackLoss(0.0F),
 m_logDisplayLevel(0U),
 m_logFileLevel(0U),
 m_logFilePath(),
@@ -95,7 +107,17 @@ m_gpsType("Fixed"),
 m_controlRemoteAddress("127.0.0.1"),
 m_controlRemotePort(0U),
 m_controlLocalAddress("127.0.0.1"),
-m_controlLocalPort(0U)
+m_controlLocalPort(0U),
+m_threadsLockMemory(false),
+m_threadsMainPolicy("Other"),
+m_threadsMainPriority(0U),
+m_threadsMainCPUs(),
+m_threadsAudioPolicy("Other"),
+m_threadsAudioPriority(0U),
+m_threadsAudioCPUs(),
+m_threadsDSPPolicy("Other"),
+m_threadsDSPPriority(0U),
+m_threadsDSPCPUs()
 {
 }
 
@@ -139,6 +161,8 @@ bool CConf::read()
 				section = SECTION_GPSD;
 			else if (::strncmp(buffer, "[Control]", 9U) == 0)
 				section = SECTION_CONTROL;
+			else if (::strncmp(buffer, "[Threads]", 9U) == 0)
+				section = SECTION_THREADS;
 			else
 				section = SECTION_NONE;
 
@@ -192,6 +216,22 @@ bool CConf::read()
 				m_audioMicGain = (unsigned int)::atoi(value);
 			else if (::strcmp(key, "Volume") == 0)
 				m_audioVolume = (unsigned int)::atoi(value);
+			else if (::strcmp(key, "Resampler") == 0)
+				m_audioResampler = value;
+			else if (::strcmp(key, "NativeRate") == 0)
+				m_audioNativeRate = ::atoi(value) == 1;
+			else if (::strcmp(key, "MMAP") == 0)
+				m_audioMMAP = ::atoi(value) == 1;
+			else if (::strcmp(key, "Channel") == 0)
+				m_audioChannel = value;
+			else if (::strcmp(key, "JACKQuantum") == 0)
+				m_audioJACKQuantum = (unsigned int)::atoi(value);
+			else if (::strcmp(key, "JitterTarget") == 0)
+				m_audioJitterTarget = (unsigned int)::atoi(value);
+			else if (::strcmp(key, "ConcealBER") == 0)
+				m_audioConcealBER = (unsigned int)::atoi(value);
+			else if (::strcmp(key, "ConcealHang") == 0)
+				m_audioConcealHang = (unsigned int)::atoi(value);
 		} else if (section == SECTION_MODEM) {
 			if (::strcmp(key, "Port") == 0)
 				m_modemPort = value;
@@ -225,6 +265,12 @@ bool CConf::read()
 				m_modemTrace = ::atoi(value) == 1;
 			else if (::strcmp(key, "Debug") == 0)
 				m_modemDebug = ::atoi(value) == 1;
+			else if (::strcmp(key, "LoopbackDelay") == 0)
+				m_modemLoopbackDelay = (unsigned int)::atoi(value);
+			else if (::strcmp(key, "LoopbackBER") == 0)
+				m_modemLoopbackBER = float(::atof(value));
+			else if (::strcmp(key, "LoopbackLoss") == 0)
+				m_modemLoopbackLoss = float(::atof(value));
 		} else if (section == SECTION_LOG) {
 			if (::strcmp(key, "FilePath") == 0)
 				m_logFilePath = value;
@@ -287,6 +333,40 @@ bool CConf::read()
 				m_controlLocalAddress = value;
 			else if (::strcmp(key, "LocalPort") == 0)
 				m_controlLocalPort = (unsigned short)::atoi(value);
+		} else if (section == SECTION_THREADS) {
+			if (::strcmp(key, "LockMemory") == 0)
+				m_threadsLockMemory = ::atoi(value) == 1;
+			else if (::strcmp(key, "MainPolicy") == 0)
+				m_threadsMainPolicy = value;
+			else if (::strcmp(key, "MainPriority") == 0)
+				m_threadsMainPriority = (unsigned int)::atoi(value);
+			else if (::strcmp(key, "MainCPUs") == 0) {
+				char* p = ::strtok(value, ", ");
+				while (p != NULL) {
+					m_threadsMainCPUs.push_back((unsigned int)::atoi(p));
+					p = ::strtok(NULL, ", ");
+				}
+			} else if (::strcmp(key, "AudioPolicy") == 0)
+				m_threadsAudioPolicy = value;
+			else if (::strcmp(key, "AudioPriority") == 0)
+				m_threadsAudioPriority = (unsigned int)::atoi(value);
+			else if (::strcmp(key, "AudioCPUs") == 0) {
+				char* p = ::strtok(value, ", ");
+				while (p != NULL) {
+					m_threadsAudioCPUs.push_back((unsigned int)::atoi(p));
+					p = ::strtok(NULL, ", ");
+				}
+			} else if (::strcmp(key, "DSPPolicy") == 0)
+				m_threadsDSPPolicy = value;
+			else if (::strcmp(key, "DSPPriority") == 0)
+				m_threadsDSPPriority = (unsigned int)::atoi(value);
+			else if (::strcmp(key, "DSPCPUs") == 0) {
+				char* p = ::strtok(value, ", ");
+				while (p != NULL) {
+					m_threadsDSPCPUs.push_back((unsigned int)::atoi(p));
+					p = ::strtok(NULL, ", ");
+				}
+			}
 		}
 	}
 
@@ -345,6 +425,46 @@ unsigned int CConf::getAudioVolume() const
 	return m_audioVolume;
 }
 
+std::string CConf::getAudioResampler() const
+{
+	return m_audioResampler;
+}
+
+bool CConf::getAudioNativeRate() const
+{
+	return m_audioNativeRate;
+}
+
+bool CConf::getAudioMMAP() const
+{
+	return m_audioMMAP;
+}
+
+std::string CConf::getAudioChannel() const
+{
+	return m_audioChannel;
+}
+
+unsigned int CConf::getAudioJACKQuantum() const
+{
+	return m_audioJACKQuantum;
+}
+
+unsigned int CConf::getAudioJitterTarget() const
+{
+	return m_audioJitterTarget;
+}
+
+unsigned int CConf::getAudioConcealBER() const
+{
+	return m_audioConcealBER;
+}
+
+unsigned int CConf::getAudioConcealHang() const
+{
+	return m_audioConcealHang;
+}
+
 std::string CConf::getModemPort() const
 {
 	return m_modemPort;
@@ -425,6 +545,21 @@ bool CConf::getModemDebug() const
 	return m_modemDebug;
 }
 
+unsigned int CConf::getModemLoopbackDelay() const
+{
+	return m_modemLoopbackDelay;
+}
+
+float CConf::getModemLoopbackBER() const
+{
+	return m_modemLoopbackBER;
+}
+
+float CConf::getModemLoopbackLoss() const
+{
+	return m_modemLoopbackLoss;
+}
+
 unsigned int CConf::getLogDisplayLevel() const
 {
 	return m_logDisplayLevel;
@@ -565,3 +700,52 @@ unsigned short CConf::getControlLocalPort() const
 	return m_controlLocalPort;
 }
 
+bool CConf::getThreadsLockMemory() const
+{
+	return m_threadsLockMemory;
+}
+
+std::string CConf::getThreadsMainPolicy() const
+{
+	return m_threadsMainPolicy;
+}
+
+unsigned int CConf::getThreadsMainPriority() const
+{
+	return m_threadsMainPriority;
+}
+
+std::vector<unsigned int> CConf::getThreadsMainCPUs() const
+{
+	return m_threadsMainCPUs;
+}
+
+std::string CConf::getThreadsAudioPolicy() const
+{
+	return m_threadsAudioPolicy;
+}
+
+unsigned int CConf::getThreadsAudioPriority() const
+{
+	return m_threadsAudioPriority;
+}
+
+std::vector<unsigned int> CConf::getThreadsAudioCPUs() const
+{
+	return m_threadsAudioCPUs;
+}
+
+std::string CConf::getThreadsDSPPolicy() const
+{
+	return m_threadsDSPPolicy;
+}
+
+unsigned int CConf::getThreadsDSPPriority() const
+{
+	return m_threadsDSPPriority;
+}
+
+std::vector<unsigned int> CConf::getThreadsDSPCPUs() const
+{
+	return m_threadsDSPCPUs;
+}
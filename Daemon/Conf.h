@@ -45,6 +45,14 @@ public:
 	std::string  getAudioOutputDevice() const;
 	unsigned int getAudioMicGain() const;
 	unsigned int getAudioVolume() const;
+	std::string  getAudioResampler() const;
+	bool         getAudioNativeRate() const;
+	bool         getAudioMMAP() const;
+	std::string  getAudioChannel() const;
+	unsigned int getAudioJACKQuantum() const;
+	unsigned int getAudioJitterTarget() const;
+	unsigned int getAudioConcealBER() const;
+	unsigned int getAudioConcealHang() const;
 
 	// The Modem section
 	std::string  getModemPort() const;
@@ -63,6 +71,9 @@ public:
 	std::string  getModemRSSIMappingFile() const;
 	bool         getModemTrace() const;
 	bool         getModemDebug() const;
+	unsigned int getModemLoopbackDelay() const;
+	float        getModemLoopbackBER() const;
+	float        getModemLoopbackLoss() const;
 
 	// The Log section
 	unsigned int getLogDisplayLevel() const;
@@ -104,6 +115,18 @@ public:
 	std::string    getControlLocalAddress() const;
 	unsigned short getControlLocalPort() const;
 
+	// The Threads section
+	bool         getThreadsLockMemory() const;
+	std::string  getThreadsMainPolicy() const;
+	unsigned int getThreadsMainPriority() const;
+	std::vector<unsigned int> getThreadsMainCPUs() const;
+	std::string  getThreadsAudioPolicy() const;
+	unsigned int getThreadsAudioPriority() const;
+	std::vector<unsigned int> getThreadsAudioCPUs() const;
+	std::string  getThreadsDSPPolicy() const;
+	unsigned int getThreadsDSPPriority() const;
+	std::vector<unsigned int> getThreadsDSPCPUs() const;
+
 private:
 	std::string  m_file;
 	std::string  m_callsign;
@@ -118,6 +141,14 @@ private:
 	std::string  m_audioOutputDevice;
 	unsigned int m_audioMicGain;
 	unsigned int m_audioVolume;
+	std::string  m_audioResampler;
+	bool         m_audioNativeRate;
+	bool         m_audioMMAP;
+	std::string  m_audioChannel;
+	unsigned int m_audioJACKQuantum;
+	unsigned int m_audioJitterTarget;
+	unsigned int m_audioConcealBER;
+	unsigned int m_audioConcealHang;
 
 	std::string  m_modemPort;
 	unsigned int m_modemSpeed;
@@ -135,6 +166,9 @@ private:
 	std::string  m_modemRSSIMappingFile;
 	bool         m_modemTrace;
 	bool         m_modemDebug;
+	unsigned int m_modemLoopbackDelay;
+	float        m_modemLoopbackBER;
+	float        m_modemLoopbackLoss;
 
 	unsigned int m_logDisplayLevel;
 	unsigned int m_logFileLevel;
@@ -169,6 +203,17 @@ private:
 	unsigned short m_controlRemotePort;
 	std::string    m_controlLocalAddress;
 	unsigned short m_controlLocalPort;
+
+	bool         m_threadsLockMemory;
+	std::string  m_threadsMainPolicy;
+	unsigned int m_threadsMainPriority;
+	std::vector<unsigned int> m_threadsMainCPUs;
+	std::string  m_threadsAudioPolicy;
+	unsigned int m_threadsAudioPriority;
+	std::vector<unsigned int> m_threadsAudioCPUs;
+	std::string  m_threadsDSPPolicy;
+	unsigned int m_threadsDSPPriority;
+	std::vector<unsigned int> m_threadsDSPCPUs;
 };
 
 #endif
@@ -0,0 +1,243 @@
+/*
+ *   Copyright (C) 2022 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include "DSPWorker.h"
+#include "Log.h"
+
+#include <cassert>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+
+#include <sys/eventfd.h>
+#include <poll.h>
+#include <unistd.h>
+
+// Room for a second of frames, each with its length and arrival time
+const unsigned int DSP_RECORD_LENGTH = 1U + sizeof(unsigned long long) + DSP_MAX_FRAME_LENGTH;
+const unsigned int DSP_QUEUE_FRAMES  = 25U;
+
+// Tick quickly while RX is holding a lost transmission open, it fills the
+// frame slots from the clock
+const int DSP_BUSY_TICK_MS = 10;
+const int DSP_IDLE_TICK_MS = 250;
+
+const unsigned int DSP_STATS_INTERVAL_MS = 60000U;
+
+static unsigned long long nowNS()
+{
+	struct timespec now;
+	::clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+CDSPLatency::CDSPLatency() :
+m_count(0U),
+m_total(0ULL),
+m_max(0ULL)
+{
+}
+
+void CDSPLatency::add(unsigned long long ns)
+{
+	m_count++;
+	m_total += ns;
+
+	if (ns > m_max)
+		m_max = ns;
+}
+
+void CDSPLatency::log(const char* name)
+{
+	assert(name != NULL);
+
+	if (m_count > 0U)
+		LogDebug("DSP %s: %u frames, average %lluus, maximum %lluus", name, m_count, (m_total / m_count) / 1000ULL, m_max / 1000ULL);
+
+	m_count = 0U;
+	m_total = 0ULL;
+	m_max   = 0ULL;
+}
+
+CDSPWorker::CDSPWorker(CM17RX& rx, CM17TX& tx, CReactor& reactor) :
+CThread("DSP"),
+m_rx(rx),
+m_tx(tx),
+m_reactor(reactor),
+m_queue(DSP_QUEUE_FRAMES * DSP_RECORD_LENGTH, "DSP RX Frames"),
+m_eventFD(-1),
+m_killed(false),
+m_rxQueue(),
+m_rxDecode(),
+m_txEncode(),
+m_statsWatch()
+{
+}
+
+CDSPWorker::~CDSPWorker()
+{
+}
+
+bool CDSPWorker::open()
+{
+	m_eventFD = ::eventfd(0U, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (m_eventFD == -1) {
+		LogError("Cannot create the DSP eventfd, errno=%d", errno);
+		return false;
+	}
+
+	return run();
+}
+
+bool CDSPWorker::writeRX(const unsigned char* data, unsigned int len)
+{
+	assert(data != NULL);
+	assert(len > 0U && len <= DSP_MAX_FRAME_LENGTH);
+
+	if (!hasRXSpace())
+		return false;
+
+	// One record so that the worker never sees half a frame
+	unsigned char record[DSP_RECORD_LENGTH];
+	unsigned long long now = nowNS();
+
+	record[0U] = len;
+	::memcpy(record + 1U, &now, sizeof(unsigned long long));
+	::memcpy(record + 1U + sizeof(unsigned long long), data, len);
+
+	m_queue.addData(record, 1U + sizeof(unsigned long long) + len);
+
+	notify();
+
+	return true;
+}
+
+bool CDSPWorker::hasRXSpace() const
+{
+	return m_queue.freeSpace() >= DSP_RECORD_LENGTH;
+}
+
+void CDSPWorker::notify()
+{
+	if (m_eventFD == -1)
+		return;
+
+	uint64_t value = 1U;
+	ssize_t n = ::write(m_eventFD, &value, sizeof(uint64_t));
+	(void)n;
+}
+
+void CDSPWorker::entry()
+{
+	LogMessage("Starting DSP worker thread");
+
+	CStopWatch stopWatch;
+	stopWatch.start();
+
+	m_statsWatch.start();
+
+	while (!m_killed) {
+		struct pollfd pfd;
+		pfd.fd      = m_eventFD;
+		pfd.events  = POLLIN;
+		pfd.revents = 0;
+
+		if (::poll(&pfd, 1, m_rx.isHolding() ? DSP_BUSY_TICK_MS : DSP_IDLE_TICK_MS) > 0) {
+			uint64_t value;
+			ssize_t ret = ::read(m_eventFD, &value, sizeof(uint64_t));
+			(void)ret;
+		}
+
+		unsigned int ms = stopWatch.elapsed();
+		stopWatch.start();
+
+		m_rx.clock(ms);
+
+		processRX();
+		processTX();
+
+		if (m_statsWatch.elapsed() >= DSP_STATS_INTERVAL_MS) {
+			m_rxQueue.log("RX queue");
+			m_rxDecode.log("RX decode");
+			m_txEncode.log("TX encode");
+			m_statsWatch.start();
+		}
+	}
+
+	LogMessage("Stopping DSP worker thread");
+}
+
+void CDSPWorker::processRX()
+{
+	while (!m_queue.isEmpty()) {
+		unsigned char len = 0U;
+		m_queue.getData(&len, 1U);
+
+		unsigned long long queued = 0ULL;
+		m_queue.getData((unsigned char*)&queued, sizeof(unsigned long long));
+
+		unsigned char data[DSP_MAX_FRAME_LENGTH];
+		m_queue.getData(data, len);
+
+		unsigned long long start = nowNS();
+		m_rxQueue.add(start - queued);
+
+		m_rx.write(data, len);
+
+		m_rxDecode.add(nowNS() - start);
+	}
+}
+
+void CDSPWorker::processTX()
+{
+	bool encoded = false;
+
+	for (;;) {
+		unsigned long long start = nowNS();
+
+		if (!m_tx.process())
+			break;
+
+		m_txEncode.add(nowNS() - start);
+		encoded = true;
+	}
+
+	// Wake the main loop to send the frames to the modem
+	if (encoded)
+		m_reactor.notify();
+}
+
+void CDSPWorker::kill()
+{
+	m_killed = true;
+
+	notify();
+}
+
+void CDSPWorker::close()
+{
+	kill();
+	wait();
+
+	if (m_eventFD != -1) {
+		::close(m_eventFD);
+		m_eventFD = -1;
+	}
+}
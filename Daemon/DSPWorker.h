@@ -0,0 +1,94 @@
+/*
+ *   Copyright (C) 2022 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#if !defined(DSPWORKER_H)
+#define	DSPWORKER_H
+
+#include "SPSCRingBuffer.h"
+#include "M17Defines.h"
+#include "StopWatch.h"
+#include "Reactor.h"
+#include "Thread.h"
+#include "M17RX.h"
+#include "M17TX.h"
+
+#include <atomic>
+
+// The largest frame from the modem, the tag, the frame and the RSSI
+const unsigned int DSP_MAX_FRAME_LENGTH = M17_FRAME_LENGTH_BYTES + 4U;
+
+// The time spent in one stage of the pipeline, in microseconds
+class CDSPLatency {
+public:
+	CDSPLatency();
+
+	void add(unsigned long long ns);
+
+	// Log the counts since the last call and reset them
+	void log(const char* name);
+
+private:
+	unsigned int       m_count;
+	unsigned long long m_total;
+	unsigned long long m_max;
+};
+
+// Runs the FEC, codec and resampling for RX and TX away from the main loop,
+// so that a slow encode or decode can't hold up the modem. Frames from the
+// modem arrive through a bounded lock free queue, the audio capture thread
+// wakes it when there is TX audio, and the main loop is woken when there
+// are TX frames for the modem.
+class CDSPWorker : public CThread {
+public:
+	CDSPWorker(CM17RX& rx, CM17TX& tx, CReactor& reactor);
+	virtual ~CDSPWorker();
+
+	bool open();
+
+	// Called from the main loop, false if the queue is full and the frame
+	// should be left with the modem for now
+	bool writeRX(const unsigned char* data, unsigned int len);
+
+	bool hasRXSpace() const;
+
+	// Safe to call from any thread
+	void notify();
+
+	virtual void entry();
+
+	void kill();
+
+	void close();
+
+private:
+	CM17RX&                        m_rx;
+	CM17TX&                        m_tx;
+	CReactor&                      m_reactor;
+	CSPSCRingBuffer<unsigned char> m_queue;
+	int                            m_eventFD;
+	std::atomic<bool>              m_killed;
+	CDSPLatency                    m_rxQueue;
+	CDSPLatency                    m_rxDecode;
+	CDSPLatency                    m_txEncode;
+	CStopWatch                     m_statsWatch;
+
+	void processRX();
+	void processTX();
+};
+
+#endif
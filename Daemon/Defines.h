@@ -70,4 +70,16 @@ enum HW_TYPE {
 	HWT_UNKNOWN
 };
 
+enum RESAMPLER_TYPE {
+	RT_NONE,
+	RT_SINC,
+	RT_POLYPHASE
+};
+
+enum AUDIO_CHANNEL {
+	AC_LEFT,
+	AC_RIGHT,
+	AC_MIX
+};
+
 #endif
@@ -105,7 +105,7 @@ bool CGPIO::open()
 			return false;
 		}
 
-		int ret = ::gpiod_line_request_input(m_ptt, "M17Client");
+		int ret = ::gpiod_line_request_both_edges_events(m_ptt, "M17Client");
 		if (ret == -1) {
 			LogError("Unable to set the PTT GPIO pin for input, errno=%d", errno);
 			return false;
@@ -119,7 +119,7 @@ bool CGPIO::open()
 			return false;
 		}
 
-		int ret = ::gpiod_line_request_input(m_volumeUp, "M17Client");
+		int ret = ::gpiod_line_request_both_edges_events(m_volumeUp, "M17Client");
 		if (ret == -1) {
 			LogError("Unable to set the Volume Up GPIO pin for input, errno=%d", errno);
 			return false;
@@ -133,7 +133,7 @@ bool CGPIO::open()
 			return false;
 		}
 
-		int ret = ::gpiod_line_request_input(m_volumeDown, "M17Client");
+		int ret = ::gpiod_line_request_both_edges_events(m_volumeDown, "M17Client");
 		if (ret == -1) {
 			LogError("Unable to set the Volume Down GPIO pin for input, errno=%d", errno);
 			return false;
@@ -170,6 +170,8 @@ bool CGPIO::getPTT()
 	if (m_ptt == NULL)
 		return false;
 	
+	readEvents(m_ptt);
+
 	int ret = ::gpiod_line_get_value(m_ptt);
 	switch (ret) {
 		case 1:
@@ -187,6 +189,8 @@ bool CGPIO::getVolumeUp()
 	if (m_volumeUp == NULL)
 		return false;
 	
+	readEvents(m_volumeUp);
+
 	int ret = ::gpiod_line_get_value(m_volumeUp);
 	switch (ret) {
 		case 1:
@@ -204,6 +208,8 @@ bool CGPIO::getVolumeDown()
 	if (m_volumeDown == NULL)
 		return false;
 	
+	readEvents(m_volumeDown);
+
 	int ret = ::gpiod_line_get_value(m_volumeDown);
 	switch (ret) {
 		case 1:
@@ -216,6 +222,31 @@ bool CGPIO::getVolumeDown()
 	}
 }
 
+void CGPIO::getFDs(std::vector<int>& fds) const
+{
+	if (m_ptt != NULL)
+		fds.push_back(::gpiod_line_event_get_fd(m_ptt));
+
+	if (m_volumeUp != NULL)
+		fds.push_back(::gpiod_line_event_get_fd(m_volumeUp));
+
+	if (m_volumeDown != NULL)
+		fds.push_back(::gpiod_line_event_get_fd(m_volumeDown));
+}
+
+void CGPIO::readEvents(gpiod_line* line)
+{
+	assert(line != NULL);
+
+	// Consume any pending edge events so that the fd stops being readable
+	struct timespec timeout = { 0, 0 };
+	while (::gpiod_line_event_wait(line, &timeout) == 1) {
+		struct gpiod_line_event event;
+		if (::gpiod_line_event_read(line, &event) == -1)
+			break;
+	}
+}
+
 void CGPIO::close()
 {
 	assert(m_chip != NULL);
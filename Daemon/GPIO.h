@@ -22,6 +22,7 @@
 #define	GPIO_H
 
 #include <string>
+#include <vector>
 
 #include <gpiod.h>
 
@@ -40,6 +41,8 @@ public:
 	bool getVolumeUp();
 	bool getVolumeDown();
 
+	void getFDs(std::vector<int>& fds) const;
+
 	void close();
 
 private:
@@ -58,6 +61,8 @@ private:
 	gpiod_line*  m_ptt;
 	gpiod_line*  m_volumeUp;
 	gpiod_line*  m_volumeDown;
+
+	void readEvents(gpiod_line* line);
 };
 
 #endif
@@ -64,6 +64,11 @@ void CGPSD::close()
 	::gps_close(&m_gpsdData);
 }
 
+int CGPSD::getFD() const
+{
+	return m_gpsdData.gps_fd;
+}
+
 void CGPSD::clock(unsigned int ms)
 {
 	m_timer.clock(ms);
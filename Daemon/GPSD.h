@@ -41,6 +41,8 @@ public:
 
 	void close();
 
+	int getFD() const;
+
 private:
 	std::string       m_gpsdAddress;
 	std::string       m_gpsdPort;
@@ -4,7 +4,6 @@
  */
 
 #include "Golay24128.h"
-#include "Utils.h"
 
 #include <cstdio>
 #include <cassert>
@@ -1045,29 +1044,42 @@ static const unsigned int DECODING_TABLE_23127[] = {
 #define MASK12          0xfffff800   /* auxiliary vector for testing */
 #define GENPOL          0x00000c75   /* generator polinomial, g(x) */
 
-static unsigned int get_syndrome_23127(unsigned int pattern)
-/*
- * Compute the syndrome corresponding to the given pattern, i.e., the
- * remainder after dividing the pattern (when considering it as the vector
- * representation of a polynomial) by the generator polynomial, GENPOL.
- * In the program this pattern has several meanings: (1) pattern = infomation
- * bits, when constructing the encoding table; (2) pattern = error pattern,
- * when constructing the decoding table; and (3) pattern = received vector, to
- * obtain its syndrome in decoding.
- */
-{
-	unsigned int aux = X22;
- 
-	if (pattern >= X11) {
-		while (pattern & MASK12) {
-			while (!(aux & pattern))
-				aux = aux >> 1;
+// The remainder of every possible top 12 bits of a 23-bit pattern after
+// division by GENPOL, built at compile time with the original shift-divide
+// loop so that it is never run when decoding.
+struct CGolaySyndromeTable {
+	constexpr CGolaySyndromeTable() :
+	m_remainder()
+	{
+		for (unsigned int i = 0U; i < 4096U; i++) {
+			unsigned int pattern = i * X11;
+			unsigned int aux = X22;
+
+			while (pattern & MASK12) {
+				while (!(aux & pattern))
+					aux = aux >> 1;
+
+				pattern ^= (aux / X11) * GENPOL;
+			}
 
-			pattern ^= (aux / X11) * GENPOL;
+			m_remainder[i] = pattern;
 		}
 	}
 
-	return pattern;
+	unsigned int m_remainder[4096U];
+};
+
+constexpr CGolaySyndromeTable SYNDROME_TABLE;
+
+/*
+ * Compute the syndrome corresponding to the given 23-bit pattern, i.e., the
+ * remainder after dividing it by the generator polynomial, GENPOL. As the
+ * remainder is linear it is the remainder of the top 12 bits, from the table,
+ * XORed with the bottom 11 bits which are already smaller than GENPOL.
+ */
+static inline unsigned int get_syndrome_23127(unsigned int pattern)
+{
+	return SYNDROME_TABLE.m_remainder[(pattern >> 11) & 0xFFFU] ^ (pattern & 0x7FFU);
 }
 
 unsigned int CGolay24128::encode23127(unsigned int data)
@@ -1097,14 +1109,14 @@ bool CGolay24128::decode24128(unsigned int in, unsigned int& out)
 
 	out = in ^ error_pattern;
 
-	bool valid = (CUtils::countBits(syndrome) < 3U) || !(CUtils::countBits(out) & 1);
+	bool valid = (__builtin_popcount(syndrome) < 3) || !(__builtin_popcount(out) & 1);
 
 	out >>= 12;
 
 	return valid;
 }
 
-bool CGolay24128::decode24128(unsigned char* in, unsigned int& out)
+bool CGolay24128::decode24128(const unsigned char* in, unsigned int& out)
 {
 	assert(in != NULL);
 
@@ -1112,3 +1124,16 @@ bool CGolay24128::decode24128(unsigned char* in, unsigned int& out)
 
 	return decode24128(code, out);
 }
+
+bool CGolay24128::decode24128x4(const unsigned char* in, unsigned int* out)
+{
+	assert(in != NULL);
+	assert(out != NULL);
+
+	bool valid = true;
+
+	for (unsigned int i = 0U; i < 4U; i++, in += 3U)
+		valid &= decode24128((in[0U] << 16) | (in[1U] << 8) | (in[2U] << 0), out[i]);
+
+	return valid;
+}
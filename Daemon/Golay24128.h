@@ -27,7 +27,11 @@ public:
 	static unsigned int decode23127(unsigned int code);
 
 	static bool decode24128(unsigned int in, unsigned int& out);
-	static bool decode24128(unsigned char* in, unsigned int& out);
+	static bool decode24128(const unsigned char* in, unsigned int& out);
+
+	// Decode the four consecutive codewords of an M17 LICH, only returns
+	// true if all four are valid
+	static bool decode24128x4(const unsigned char* in, unsigned int* out);
 };
 
 #endif
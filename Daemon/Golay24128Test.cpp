@@ -0,0 +1,190 @@
+/*
+ *   Copyright (C) 2022 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include "Golay24128.h"
+#include "TestUtils.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+
+// The shift-divide syndrome that decode24128() used before the syndrome
+// table, kept here as the reference and for the timing comparison
+#define X22             0x00400000   /* vector representation of X^{22} */
+#define X11             0x00000800   /* vector representation of X^{11} */
+#define MASK12          0xfffff800   /* auxiliary vector for testing */
+#define GENPOL          0x00000c75   /* generator polinomial, g(x) */
+
+static unsigned int get_syndrome_23127(unsigned int pattern)
+{
+	unsigned int aux = X22;
+
+	if (pattern >= X11) {
+		while (pattern & MASK12) {
+			while (!(aux & pattern))
+				aux = aux >> 1;
+
+			pattern ^= (aux / X11) * GENPOL;
+		}
+	}
+
+	return pattern;
+}
+
+static unsigned int countBits(unsigned int v)
+{
+	unsigned int count = 0U;
+
+	while (v != 0U) {
+		v &= v - 1U;
+		count++;
+	}
+
+	return count;
+}
+
+// The code is perfect, every syndrome belongs to exactly one pattern of up
+// to three errors in 23 bits
+static unsigned int DECODING_TABLE[2048U];
+
+static void buildDecodingTable()
+{
+	for (unsigned int i = 0U; i < 23U; i++) {
+		for (unsigned int j = i; j < 23U; j++) {
+			for (unsigned int k = j; k < 23U; k++) {
+				unsigned int pattern = (1U << i) | (1U << j) | (1U << k);
+				DECODING_TABLE[get_syndrome_23127(pattern)] = pattern;
+			}
+		}
+	}
+
+	DECODING_TABLE[0U] = 0U;
+}
+
+static bool decode24128(unsigned int in, unsigned int& out)
+{
+	unsigned int syndrome = get_syndrome_23127(in >> 1);
+	unsigned int error_pattern = DECODING_TABLE[syndrome] << 1;
+
+	out = in ^ error_pattern;
+
+	bool valid = (countBits(syndrome) < 3U) || !(countBits(out) & 1);
+
+	out >>= 12;
+
+	return valid;
+}
+
+static unsigned long long nowNS()
+{
+	struct timespec now;
+	::clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+int main(int argc, char** argv)
+{
+	CTestUtils::seed(argc, argv);
+
+	buildDecodingTable();
+
+	unsigned int failures = 0U;
+
+	// Every codeword with every pattern of up to three errors
+	unsigned int patterns = 0U;
+	for (unsigned int e = 0U; e < (1U << 24); e++) {
+		if (countBits(e) > 3U)
+			continue;
+
+		patterns++;
+
+		for (unsigned int data = 0U; data < 4096U; data++) {
+			unsigned int out;
+			CGolay24128::decode24128(CGolay24128::encode24128(data) ^ e, out);
+			if (out != data) {
+				if (failures == 0U)
+					::fprintf(stderr, "Golay24128Test: data %03X with errors %06X decoded as %03X\n", data, e, out);
+				failures++;
+			}
+		}
+	}
+
+	bool ok = CTestUtils::report("correction", 4096U * patterns, failures);
+
+	// Every 24-bit input against the shift-divide decoder, including the
+	// validity flag
+	unsigned int differences = 0U;
+	for (unsigned int in = 0U; in < (1U << 24); in++) {
+		unsigned int out1, out2;
+		bool valid1 = decode24128(in, out1);
+		bool valid2 = CGolay24128::decode24128(in, out2);
+		if (out1 != out2 || valid1 != valid2) {
+			if (differences == 0U)
+				::fprintf(stderr, "Golay24128Test: input %06X differs from the reference\n", in);
+			differences++;
+		}
+	}
+
+	ok &= CTestUtils::report("reference", 1U << 24, differences);
+
+	// Four codewords at once against one at a time
+	unsigned int x4Differences = 0U;
+	for (unsigned int n = 0U; n < 100000U; n++) {
+		unsigned char in[12U];
+		CTestUtils::randomBytes(in, 12U);
+
+		unsigned int out[4U];
+		bool valid = CGolay24128::decode24128x4(in, out);
+
+		bool expected = true;
+		for (unsigned int i = 0U; i < 4U; i++) {
+			unsigned int single;
+			expected &= CGolay24128::decode24128(in + i * 3U, single);
+			if (single != out[i])
+				x4Differences++;
+		}
+
+		if (valid != expected)
+			x4Differences++;
+	}
+
+	ok &= CTestUtils::report("decode24128x4", 100000U, x4Differences);
+
+	// The timing of both over every input, the sum stops the loops being
+	// optimised away
+	unsigned int sum = 0U;
+
+	unsigned long long start = nowNS();
+	for (unsigned int in = 0U; in < (1U << 24); in++) {
+		unsigned int out;
+		sum += decode24128(in, out) ? out : 0U;
+	}
+	unsigned long long divide = nowNS() - start;
+
+	start = nowNS();
+	for (unsigned int in = 0U; in < (1U << 24); in++) {
+		unsigned int out;
+		sum += CGolay24128::decode24128(in, out) ? out : 0U;
+	}
+	unsigned long long table = nowNS() - start;
+
+	::fprintf(stdout, "timing: divide loop %.1fns, syndrome table %.1fns a codeword (%08X)\n", double(divide) / double(1U << 24), double(table) / double(1U << 24), sum);
+
+	return ok ? 0 : 1;
+}
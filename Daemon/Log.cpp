@@ -31,6 +31,7 @@
 #include <ctime>
 #include <cassert>
 #include <cstring>
+#include <mutex>
 
 static unsigned int m_fileLevel = 2U;
 static std::string m_filePath;
@@ -46,6 +47,9 @@ static struct tm m_tm;
 
 static char LEVELS[] = " DMIWEF";
 
+// Logging is done from the main, audio and DSP threads
+static std::mutex m_mutex;
+
 static bool logOpenRotate()
 {
 	bool status = false;
@@ -159,9 +163,10 @@ void Log(unsigned int level, const char* fmt, ...)
 	struct timeval now;
 	::gettimeofday(&now, NULL);
 
-	struct tm* tm = ::gmtime(&now.tv_sec);
+	struct tm tm;
+	::gmtime_r(&now.tv_sec, &tm);
 
-	::sprintf(buffer, "%c: %04d-%02d-%02d %02d:%02d:%02d.%03lld ", LEVELS[level], tm->tm_year + 1900, tm->tm_mon + 1, tm->tm_mday, tm->tm_hour, tm->tm_min, tm->tm_sec, now.tv_usec / 1000LL);
+	::sprintf(buffer, "%c: %04d-%02d-%02d %02d:%02d:%02d.%03lld ", LEVELS[level], tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday, tm.tm_hour, tm.tm_min, tm.tm_sec, now.tv_usec / 1000LL);
 #endif
 
 	va_list vl;
@@ -171,6 +176,8 @@ void Log(unsigned int level, const char* fmt, ...)
 
 	va_end(vl);
 
+	std::lock_guard<std::mutex> lock(m_mutex);
+
 	if (level >= m_fileLevel && m_fileLevel != 0U) {
 		bool ret = ::LogOpen();
 		if (!ret)
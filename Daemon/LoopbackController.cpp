@@ -0,0 +1,379 @@
+/*
+ *   Copyright (C) 2022 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include "LoopbackController.h"
+#include "Defines.h"
+#include "Log.h"
+
+#include <cstring>
+#include <cassert>
+#include <cerrno>
+#include <ctime>
+
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+const unsigned char MMDVM_FRAME_START    = 0xE0U;
+
+const unsigned char MMDVM_GET_VERSION    = 0x00U;
+const unsigned char MMDVM_GET_STATUS     = 0x01U;
+const unsigned char MMDVM_SET_CONFIG     = 0x02U;
+const unsigned char MMDVM_SET_MODE       = 0x03U;
+const unsigned char MMDVM_SET_FREQ       = 0x04U;
+
+const unsigned char MMDVM_M17_LINK_SETUP = 0x45U;
+const unsigned char MMDVM_M17_STREAM     = 0x46U;
+const unsigned char MMDVM_M17_LOST       = 0x48U;
+const unsigned char MMDVM_M17_EOT        = 0x49U;
+
+const unsigned char MMDVM_ACK            = 0x70U;
+
+const unsigned char LOOPBACK_PROTOCOL_VERSION = 1U;
+const char*         LOOPBACK_DESCRIPTION      = "MMDVM Loopback";
+
+const unsigned char CAP1_M17 = 0x20U;
+
+// The number of M17 frames the emulated modem can buffer for transmission
+const unsigned int LOOPBACK_M17_SPACE = 20U;
+
+const unsigned long long M17_FRAME_TIME_NS = 40000000ULL;
+
+const unsigned int REPLY_LENGTH = 5000U;
+
+static unsigned long long nowNS()
+{
+	struct timespec now;
+	::clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+CLoopbackController::CLoopbackController(unsigned int delay, float ber, float loss) :
+m_delay(delay * 1000000ULL),
+m_ber(ber / 100.0F),
+m_loss(loss / 100.0F),
+m_fd(-1),
+m_reply(REPLY_LENGTH, "Loopback Reply"),
+m_frames(),
+m_txEnd(0ULL),
+m_rx(false),
+m_random()
+{
+	assert(ber >= 0.0F && ber <= 100.0F);
+	assert(loss >= 0.0F && loss <= 100.0F);
+}
+
+CLoopbackController::~CLoopbackController()
+{
+}
+
+bool CLoopbackController::open()
+{
+	assert(m_fd == -1);
+
+	m_fd = ::timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+	if (m_fd < 0) {
+		LogError("Cannot create the loopback timer, errno=%d", errno);
+		return false;
+	}
+
+	m_reply.clear();
+	m_frames.clear();
+
+	m_txEnd = 0ULL;
+	m_rx    = false;
+
+	LogMessage("Using the loopback modem, delay: %llums, BER: %.4f%%, frame loss: %.1f%%", m_delay / 1000000ULL, m_ber * 100.0F, m_loss * 100.0F);
+
+	return true;
+}
+
+int CLoopbackController::read(unsigned char* buffer, unsigned int length)
+{
+	assert(buffer != NULL);
+	assert(length > 0U);
+	assert(m_fd != -1);
+
+	// Acknowledge the timer, it is set again below
+	uint64_t expirations;
+	while (::read(m_fd, &expirations, sizeof(uint64_t)) == sizeof(uint64_t))
+		;
+
+	unsigned long long now = nowNS();
+
+	clock(now);
+
+	unsigned int n = m_reply.dataSize();
+	if (n > length)
+		n = length;
+
+	if (n > 0U)
+		m_reply.getData(buffer, n);
+
+	setTimer(now);
+
+	return int(n);
+}
+
+int CLoopbackController::write(const unsigned char* buffer, unsigned int length)
+{
+	assert(buffer != NULL);
+	assert(length > 0U);
+	assert(m_fd != -1);
+
+	unsigned int offset = 0U;
+	while ((length - offset) >= 3U) {
+		unsigned int len = buffer[offset + 1U];
+		if (buffer[offset + 0U] != MMDVM_FRAME_START || len < 3U || (offset + len) > length)
+			break;
+
+		writeFrame(buffer + offset, len);
+
+		offset += len;
+	}
+
+	setTimer(nowNS());
+
+	return int(length);
+}
+
+void CLoopbackController::close()
+{
+	assert(m_fd != -1);
+
+	::close(m_fd);
+	m_fd = -1;
+}
+
+int CLoopbackController::getFD() const
+{
+	return m_fd;
+}
+
+void CLoopbackController::writeFrame(const unsigned char* buffer, unsigned int length)
+{
+	assert(buffer != NULL);
+
+	switch (buffer[2U]) {
+		case MMDVM_GET_VERSION:
+			writeVersion();
+			break;
+
+		case MMDVM_GET_STATUS:
+			writeStatus(nowNS());
+			break;
+
+		case MMDVM_SET_CONFIG:
+		case MMDVM_SET_MODE:
+		case MMDVM_SET_FREQ:
+			writeACK(buffer[2U]);
+			break;
+
+		case MMDVM_M17_LINK_SETUP:
+		case MMDVM_M17_STREAM:
+			if (length >= (M17_FRAME_LENGTH_BYTES + 4U))
+				writeM17(buffer[2U], buffer + 4U);
+			break;
+
+		case MMDVM_M17_EOT:
+			writeM17(buffer[2U], NULL);
+			break;
+
+		default:
+			// Anything else is accepted and ignored
+			break;
+	}
+}
+
+void CLoopbackController::writeM17(unsigned char type, const unsigned char* data)
+{
+	unsigned long long now = nowNS();
+
+	// Frames go out back to back at the M17 frame rate
+	if (m_txEnd < now)
+		m_txEnd = now;
+	m_txEnd += M17_FRAME_TIME_NS;
+
+	if (m_loss > 0.0F) {
+		std::uniform_real_distribution<float> dist(0.0F, 1.0F);
+		if (dist(m_random) < m_loss) {
+			// A lost EOT leaves the receiver to time out
+			if (type != MMDVM_M17_EOT)
+				return;
+
+			type = MMDVM_M17_LOST;
+		}
+	}
+
+	CLoopbackFrame frame;
+	frame.m_time = m_txEnd + m_delay;
+	frame.m_type = type;
+
+	if (data != NULL) {
+		::memcpy(frame.m_data, data, M17_FRAME_LENGTH_BYTES);
+		addErrors(frame.m_data);
+	}
+
+	m_frames.push_back(frame);
+}
+
+void CLoopbackController::writeReply(const unsigned char* buffer, unsigned int length)
+{
+	assert(buffer != NULL);
+
+	if (m_reply.freeSpace() < length) {
+		LogWarning("The loopback modem has overflowed, dropping a reply");
+		return;
+	}
+
+	m_reply.addData(buffer, length);
+}
+
+void CLoopbackController::writeACK(unsigned char type)
+{
+	unsigned char reply[4U];
+
+	reply[0U] = MMDVM_FRAME_START;
+	reply[1U] = 4U;
+	reply[2U] = MMDVM_ACK;
+	reply[3U] = type;
+
+	writeReply(reply, 4U);
+}
+
+void CLoopbackController::writeVersion()
+{
+	unsigned int length = ::strlen(LOOPBACK_DESCRIPTION);
+
+	unsigned char reply[50U];
+
+	reply[0U] = MMDVM_FRAME_START;
+	reply[1U] = length + 4U;
+	reply[2U] = MMDVM_GET_VERSION;
+	reply[3U] = LOOPBACK_PROTOCOL_VERSION;
+
+	::memcpy(reply + 4U, LOOPBACK_DESCRIPTION, length);
+
+	writeReply(reply, length + 4U);
+}
+
+void CLoopbackController::writeStatus(unsigned long long now)
+{
+	bool tx = m_txEnd > now;
+
+	unsigned int space = LOOPBACK_M17_SPACE;
+	if (tx) {
+		unsigned int queued = (unsigned int)((m_txEnd - now + M17_FRAME_TIME_NS - 1ULL) / M17_FRAME_TIME_NS);
+		space = (queued < LOOPBACK_M17_SPACE) ? (LOOPBACK_M17_SPACE - queued) : 0U;
+	}
+
+	unsigned char reply[14U];
+	::memset(reply, 0x00U, 14U);
+
+	// The version 1 status layout
+	reply[0U]  = MMDVM_FRAME_START;
+	reply[1U]  = 14U;
+	reply[2U]  = MMDVM_GET_STATUS;
+	reply[3U]  = CAP1_M17;
+	reply[4U]  = (tx || m_rx) ? MODE_M17 : MODE_IDLE;
+
+	if (tx)
+		reply[5U] |= 0x01U;
+	if (m_rx)
+		reply[5U] |= 0x40U;
+
+	reply[13U] = space;
+
+	writeReply(reply, 14U);
+}
+
+void CLoopbackController::clock(unsigned long long now)
+{
+	while (!m_frames.empty() && m_frames.front().m_time <= now) {
+		const CLoopbackFrame& frame = m_frames.front();
+
+		unsigned char reply[M17_FRAME_LENGTH_BYTES + 4U];
+		reply[0U] = MMDVM_FRAME_START;
+		reply[2U] = frame.m_type;
+
+		if (frame.m_type == MMDVM_M17_LINK_SETUP || frame.m_type == MMDVM_M17_STREAM) {
+			reply[1U] = M17_FRAME_LENGTH_BYTES + 4U;
+			reply[3U] = 0x00U;
+			::memcpy(reply + 4U, frame.m_data, M17_FRAME_LENGTH_BYTES);
+
+			m_rx = true;
+		} else {
+			reply[1U] = 3U;
+
+			m_rx = false;
+		}
+
+		writeReply(reply, reply[1U]);
+
+		m_frames.pop_front();
+	}
+}
+
+void CLoopbackController::addErrors(unsigned char* data)
+{
+	assert(data != NULL);
+
+	if (m_ber <= 0.0F)
+		return;
+
+	// The sync is left alone as the modem would not have passed the frame on
+	// without it
+	if (m_ber >= 1.0F) {
+		for (unsigned int i = M17_SYNC_LENGTH_BYTES; i < M17_FRAME_LENGTH_BYTES; i++)
+			data[i] ^= 0xFFU;
+		return;
+	}
+
+	// Skip from one error to the next rather than test every bit, the
+	// distribution needs a probability below one
+	std::geometric_distribution<unsigned int> dist(m_ber);
+
+	for (unsigned int i = M17_SYNC_LENGTH_BITS + dist(m_random); i < M17_FRAME_LENGTH_BITS; i += 1U + dist(m_random))
+		data[i / 8U] ^= 0x80U >> (i % 8U);
+}
+
+void CLoopbackController::setTimer(unsigned long long now)
+{
+	assert(m_fd != -1);
+
+	struct itimerspec timer;
+	::memset(&timer, 0x00, sizeof(struct itimerspec));
+
+	int flags = 0;
+
+	if (m_reply.hasData()) {
+		// Something to read now, make the fd readable straight away
+		timer.it_value.tv_nsec = 1;
+	} else if (!m_frames.empty()) {
+		unsigned long long time = m_frames.front().m_time;
+		if (time <= now)
+			time = now + 1ULL;
+
+		timer.it_value.tv_sec  = time / 1000000000ULL;
+		timer.it_value.tv_nsec = time % 1000000000ULL;
+		flags = TFD_TIMER_ABSTIME;
+	}
+
+	// An all zero time disarms the timer
+	::timerfd_settime(m_fd, flags, &timer, NULL);
+}
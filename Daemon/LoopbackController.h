@@ -0,0 +1,81 @@
+/*
+ *   Copyright (C) 2022 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef LoopbackController_H
+#define LoopbackController_H
+
+#include "ModemPort.h"
+#include "M17Defines.h"
+#include "RingBuffer.h"
+
+#include <random>
+#include <deque>
+
+struct CLoopbackFrame {
+	unsigned long long m_time;
+	unsigned char      m_type;
+	unsigned char      m_data[M17_FRAME_LENGTH_BYTES];
+};
+
+// Emulates enough of an MMDVM to run the client with no hardware. The version,
+// status and configuration commands are answered, and M17 frames are sent back
+// as received frames once they have been "transmitted", with an optional extra
+// delay, bit errors and frame loss. The bit error rate and the frame loss are
+// both percentages.
+class CLoopbackController : public IModemPort {
+public:
+	CLoopbackController(unsigned int delay, float ber, float loss);
+	virtual ~CLoopbackController();
+
+	virtual bool open();
+
+	virtual int read(unsigned char* buffer, unsigned int length);
+
+	virtual int write(const unsigned char* buffer, unsigned int length);
+
+	virtual void close();
+
+	virtual int getFD() const;
+
+private:
+	unsigned long long          m_delay;
+	float                       m_ber;
+	float                       m_loss;
+	int                         m_fd;
+	CRingBuffer<unsigned char>  m_reply;
+	std::deque<CLoopbackFrame>  m_frames;
+	unsigned long long          m_txEnd;
+	bool                        m_rx;
+	std::mt19937                m_random;
+
+	void writeFrame(const unsigned char* buffer, unsigned int length);
+	void writeM17(unsigned char type, const unsigned char* data);
+
+	void writeReply(const unsigned char* buffer, unsigned int length);
+	void writeACK(unsigned char type);
+	void writeVersion();
+	void writeStatus(unsigned long long now);
+
+	void clock(unsigned long long now);
+
+	void addErrors(unsigned char* data);
+
+	void setTimer(unsigned long long now);
+};
+
+#endif
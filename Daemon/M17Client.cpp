@@ -17,27 +17,32 @@
  */
 
 #include "M17Client.h"
+#include "LoopbackController.h"
 #include "UARTController.h"
-#include "codec2/codec2.h"
 #include "GitVersion.h"
 #include "UDPSocket.h"
 #include "StopWatch.h"
-#include "Version.h"
 #include "Thread.h"
+#include "Version.h"
 #include "Modem.h"
 #include "Log.h"
 
 #if defined(USE_PULSEAUDIO)
 #include "SoundPulse.h"
+#elif defined(USE_JACK)
+#include "SoundJACK.h"
 #else
 #include "SoundALSA.h"
 #endif
 
 #include <cstdio>
+#include <cerrno>
 #include <vector>
 
 #include <sys/types.h>
+#include <sys/mman.h>
 #include <unistd.h>
+#include <sched.h>
 #include <signal.h>
 #include <fcntl.h>
 #include <pwd.h>
@@ -46,6 +51,22 @@ const char* DEFAULT_INI_FILE = "/etc/M17Client.ini";
 
 const char* DELIMITER = ":";
 
+// How often the main loop wakes when there is nothing else to do, this drives
+// the modem status polling
+const unsigned int IDLE_TICK_MS = 250U;
+
+// How often the main loop wakes while transmitting or receiving
+const int BUSY_TICK_MS = 10;
+
+// The reports from the DSP worker to the main loop, each is the type, the
+// length and the text for the socket
+const unsigned char RX_EVENT_REPORT = 0U;
+const unsigned char RX_EVENT_START  = 1U;
+const unsigned char RX_EVENT_END    = 2U;
+
+const unsigned int RX_EVENT_MAX_TEXT     = 200U;
+const unsigned int RX_EVENT_QUEUE_LENGTH = 20U * (2U + RX_EVENT_MAX_TEXT);
+
 static bool m_killed = false;
 static int  m_signal = 0;
 
@@ -55,6 +76,16 @@ static void sigHandler(int signum)
 	m_signal = signum;
 }
 
+static int schedulingPolicy(const std::string& policy)
+{
+	if (policy == "FIFO")
+		return SCHED_FIFO;
+	else if (policy == "RR")
+		return SCHED_RR;
+	else
+		return SCHED_OTHER;
+}
+
 const char* HEADER1 = "This software is for use on amateur radio networks only,";
 const char* HEADER2 = "it is to be used for educational purposes only. Its use on";
 const char* HEADER3 = "commercial networks is strictly prohibited.";
@@ -114,6 +145,9 @@ m_tx(NULL),
 m_tx1(false),
 m_tx2(false),
 m_socket(NULL),
+m_reactor(NULL),
+m_dsp(NULL),
+m_rxEvents(RX_EVENT_QUEUE_LENGTH, "RX Events"),
 #if defined(USE_HAMLIB)
 m_hamLib(NULL),
 #endif
@@ -136,8 +170,12 @@ void CM17Client::readCallback(const float* input, unsigned int nSamples, int id)
 {
 	assert(m_tx != NULL);
 
-	if (nSamples > 0U)
+	if (nSamples > 0U && m_tx->isTX()) {
 		m_tx->write(input, nSamples);
+
+		// Wake the DSP worker to encode the new audio
+		m_dsp->notify();
+	}
 }
 
 void CM17Client::writeCallback(float* output, int& nSamples, int id)
@@ -236,10 +274,39 @@ int CM17Client::run()
 	LogMessage("M17Client-%s is starting", VERSION);
 	LogMessage("Built %s %s (GitID #%.7s)", __TIME__, __DATE__, gitversion);
 
+	// Keep the audio and modem paths out of swap
+	if (m_conf.getThreadsLockMemory()) {
+		if (::mlockall(MCL_CURRENT | MCL_FUTURE) == -1)
+			LogWarning("Unable to lock the memory, errno=%d", errno);
+	}
+
+	CThread::setScheduling("Main",  schedulingPolicy(m_conf.getThreadsMainPolicy()),  m_conf.getThreadsMainPriority(),  m_conf.getThreadsMainCPUs());
+	CThread::setScheduling("Audio", schedulingPolicy(m_conf.getThreadsAudioPolicy()), m_conf.getThreadsAudioPriority(), m_conf.getThreadsAudioCPUs());
+	CThread::setScheduling("DSP",   schedulingPolicy(m_conf.getThreadsDSPPolicy()),   m_conf.getThreadsDSPPriority(),   m_conf.getThreadsDSPCPUs());
+
+	// The main thread services the modem
+	CThread::setCurrent("Main");
+
 	m_modem = new CModem(false, m_conf.getModemRXInvert(), m_conf.getModemTXInvert(), m_conf.getModemPTTInvert(), m_conf.getModemTXDelay(),
 			     0U, false, m_conf.getModemTrace(), m_conf.getModemDebug());
 
-	m_modem->setPort(new CUARTController(m_conf.getModemPort(), m_conf.getModemSpeed()));
+	if (m_conf.getModemPort() == "Loopback") {
+		float ber = m_conf.getModemLoopbackBER();
+		if (!(ber >= 0.0F && ber <= 100.0F)) {
+			LogError("LoopbackBER must be a percentage from 0 to 100, not %f, using 0", ber);
+			ber = 0.0F;
+		}
+
+		float loss = m_conf.getModemLoopbackLoss();
+		if (!(loss >= 0.0F && loss <= 100.0F)) {
+			LogError("LoopbackLoss must be a percentage from 0 to 100, not %f, using 0", loss);
+			loss = 0.0F;
+		}
+
+		m_modem->setPort(new CLoopbackController(m_conf.getModemLoopbackDelay(), ber, loss));
+	} else {
+		m_modem->setPort(new CUARTController(m_conf.getModemPort(), m_conf.getModemSpeed()));
+	}
 
 	// By default use the first entry in the code plug file
 	m_modem->setRFParams(m_codePlug->getData().at(0U).m_rxFrequency, m_conf.getModemRXOffset(),
@@ -321,18 +388,25 @@ int CM17Client::run()
 	}
 #endif
 
-	CCodec2 codec3200(true);
-	CCodec2 codec1600(false);
-
 	CRSSIInterpolator* rssi = new CRSSIInterpolator;
 	if (!m_conf.getModemRSSIMappingFile().empty())
 		rssi->load(m_conf.getModemRSSIMappingFile());
 
-	m_tx = new CM17TX(m_conf.getCallsign(), m_conf.getText(), m_conf.getAudioMicGain(), codec3200, codec1600);
+	RESAMPLER_TYPE resampler = RT_POLYPHASE;
+	if (m_conf.getAudioResampler() == "SINC")
+		resampler = RT_SINC;
+	else if (m_conf.getAudioResampler() != "Polyphase")
+		LogWarning("Unknown resampler type - %s, using Polyphase", m_conf.getAudioResampler().c_str());
+
+	m_tx = new CM17TX(m_conf.getCallsign(), m_conf.getText(), m_conf.getAudioMicGain());
 	m_tx->setDestination("ALL");
+	m_tx->setResampler(resampler);
 
-	m_rx = new CM17RX(m_conf.getCallsign(), rssi, m_conf.getBleep(), codec3200, codec1600);
+	m_rx = new CM17RX(m_conf.getCallsign(), rssi, m_conf.getBleep());
 	m_rx->setVolume(m_conf.getAudioVolume());
+	m_rx->setResampler(resampler);
+	m_rx->setJitter(m_conf.getAudioJitterTarget());
+	m_rx->setConcealment(m_conf.getAudioConcealBER(), m_conf.getAudioConcealHang());
 	m_rx->setStatusCallback(this);
 
 	// By default use the first entry in the code plug file
@@ -344,43 +418,148 @@ int CM17Client::run()
 #endif
 	m_tx->setParams(m_codePlug->getData().at(0U).m_can, m_codePlug->getData().at(0U).m_mode);
 
+	m_reactor = new CReactor(IDLE_TICK_MS);
+	ret = m_reactor->open();
+	if (!ret) {
+		LogError("Unable to open the reactor");
+		::LogFinalise();
+		return 1;
+	}
+
+	int modemFD = m_modem->getFD();
+	unsigned int modemResets = m_modem->getResets();
+	m_reactor->addFD(modemFD);
+
+	for (unsigned int i = 0U; i < UDP_SOCKET_MAX; i++)
+		m_reactor->addFD(m_socket->getFD(i));
+
+#if defined(USE_GPSD)
+	if (m_gpsd != NULL)
+		m_reactor->addFD(m_gpsd->getFD());
+#endif
+
+#if defined(USE_GPIO)
+	if (m_gpio != NULL) {
+		std::vector<int> fds;
+		m_gpio->getFDs(fds);
+
+		for (std::vector<int>::const_iterator it = fds.cbegin(); it != fds.cend(); ++it)
+			m_reactor->addFD(*it);
+	}
+#endif
+
+#if !defined(USE_PULSEAUDIO) && !defined(USE_JACK)
+	AUDIO_CHANNEL channel = AC_MIX;
+	if (m_conf.getAudioChannel() == "Left")
+		channel = AC_LEFT;
+	else if (m_conf.getAudioChannel() == "Right")
+		channel = AC_RIGHT;
+	else if (m_conf.getAudioChannel() != "Mix")
+		LogWarning("Unknown audio channel - %s, using Mix", m_conf.getAudioChannel().c_str());
+#endif
+
+	ret = false;
+
+	// Try the codec rate first, so that no resampling is needed
+	if (m_conf.getAudioNativeRate()) {
+		m_tx->setResampler(RT_NONE);
+		m_rx->setResampler(RT_NONE);
+
 #if defined(USE_PULSEAUDIO)
-	m_sound = new CSoundPulse(m_conf.getAudioInputDevice(), m_conf.getAudioOutputDevice(), SOUNDCARD_SAMPLE_RATE, SOUNDCARD_BLOCK_SIZE);
+		m_sound = new CSoundPulse(m_conf.getAudioInputDevice(), m_conf.getAudioOutputDevice(), CODEC_SAMPLE_RATE, CODEC_BLOCK_SIZE);
+#elif defined(USE_JACK)
+		m_sound = new CSoundJACK(m_conf.getAudioInputDevice(), m_conf.getAudioOutputDevice(), CODEC_SAMPLE_RATE, CODEC_BLOCK_SIZE, m_conf.getAudioJACKQuantum());
 #else
-	m_sound = new CSoundALSA(m_conf.getAudioInputDevice(), m_conf.getAudioOutputDevice(), SOUNDCARD_SAMPLE_RATE, SOUNDCARD_BLOCK_SIZE);
+		m_sound = new CSoundALSA(m_conf.getAudioInputDevice(), m_conf.getAudioOutputDevice(), CODEC_SAMPLE_RATE, CODEC_BLOCK_SIZE, m_conf.getAudioMMAP(), channel);
 #endif
 
-	m_sound->setCallback(this);
-	ret = m_sound->open();
+		m_sound->setCallback(this);
+		ret = m_sound->open();
+		if (!ret) {
+			LogWarning("The sound card does not support %u Hz, falling back to %u Hz", CODEC_SAMPLE_RATE, SOUNDCARD_SAMPLE_RATE);
+
+			delete m_sound;
+
+			m_tx->setResampler(resampler);
+			m_rx->setResampler(resampler);
+		}
+	}
+
+	if (!ret) {
+#if defined(USE_PULSEAUDIO)
+		m_sound = new CSoundPulse(m_conf.getAudioInputDevice(), m_conf.getAudioOutputDevice(), SOUNDCARD_SAMPLE_RATE, SOUNDCARD_BLOCK_SIZE);
+#elif defined(USE_JACK)
+		m_sound = new CSoundJACK(m_conf.getAudioInputDevice(), m_conf.getAudioOutputDevice(), SOUNDCARD_SAMPLE_RATE, SOUNDCARD_BLOCK_SIZE, m_conf.getAudioJACKQuantum());
+#else
+		m_sound = new CSoundALSA(m_conf.getAudioInputDevice(), m_conf.getAudioOutputDevice(), SOUNDCARD_SAMPLE_RATE, SOUNDCARD_BLOCK_SIZE, m_conf.getAudioMMAP(), channel);
+#endif
+
+		m_sound->setCallback(this);
+		ret = m_sound->open();
+	}
+
 	if (!ret) {
 		LogError("Unable to open the sound card");
 		::LogFinalise();
 		return 1;
 	}
 
+	// The codec and FEC work is done here, the status callbacks are called from it
+	m_dsp = new CDSPWorker(*m_rx, *m_tx, *m_reactor);
+	ret = m_dsp->open();
+	if (!ret) {
+		LogError("Unable to start the DSP worker");
+		::LogFinalise();
+		return 1;
+	}
+
 	CStopWatch stopWatch;
 	stopWatch.start();
 
 	LogMessage("M17Client-%s is running", VERSION);
 
 	while (!m_killed) {
-		m_tx->process();
+		unsigned int ms = stopWatch.elapsed();
+		stopWatch.start();
+
+#if defined(USE_GPSD)
+		if (m_gpsd != NULL)
+			m_gpsd->clock(ms);
+#endif
+		m_modem->clock(ms);
+
+		// The modem port is closed and reopened when the modem is reset
+		if (m_modem->getResets() != modemResets) {
+			m_reactor->removeFD(modemFD);
+
+			modemFD     = m_modem->getFD();
+			modemResets = m_modem->getResets();
+
+			m_reactor->addFD(modemFD);
+		}
+
+		// Set when there may be more frames waiting to be moved
+		bool more = false;
 
 		bool tx = false;
 		if (m_modem->hasM17Space()) {
-			unsigned char data[M17_FRAME_LENGTH_BYTES];
+			unsigned char data[M17_FRAME_LENGTH_BYTES + 2U];
 			unsigned int len = m_tx->read(data);
 			if (len > 0U) {
 				m_modem->writeM17Data(data, len);
-				tx = true;
+				tx   = true;
+				more = true;
 			}
 		}
 
-		if (!tx) {
-			unsigned char data[M17_FRAME_LENGTH_BYTES];
+		// Leave the frames with the modem while the DSP worker catches up
+		if (!tx && m_dsp->hasRXSpace()) {
+			unsigned char data[DSP_MAX_FRAME_LENGTH];
 			unsigned int len = m_modem->readM17Data(data);
-			if (len > 0U)
-				m_rx->write(data, len);
+			if (len > 0U) {
+				m_dsp->writeRX(data, len);
+				more = true;
+			}
 		}
 
 		char command[100U];
@@ -392,6 +571,8 @@ int CM17Client::run()
 			parseCommand(command);
 		}
 
+		processRXEvents();
+
 #if defined(USE_GPSD)
 		if (m_gpsd != NULL) {
 			float latitude, longitude;
@@ -404,6 +585,8 @@ int CM17Client::run()
 		}
 #endif
 
+		bool volumeHeld = false;
+
 #if defined(USE_GPIO)
 		if (m_gpio != NULL) {
 			bool tx = m_gpio->getPTT();
@@ -439,21 +622,20 @@ int CM17Client::run()
 				LogDebug("Volume set to %u", volume);
 
 				m_rx->setVolume(volume);
+
+				volumeHeld = true;
 			}
 		}
 #endif
 
-		unsigned int ms = stopWatch.elapsed();
-		stopWatch.start();
-
-#if defined(USE_GPSD)
-		if (m_gpsd != NULL)
-			m_gpsd->clock(ms);
-#endif
-		m_modem->clock(ms);
-
-		if (ms < 10U)
-			CThread::sleep(10U);
+		// Sleep until the modem, a socket, a GPIO line or the sound card
+		// has something for us, polling more often while active
+		if (more)
+			m_reactor->wait(0);
+		else if (m_tx->isTX() || m_modem->hasTX() || !m_dsp->hasRXSpace() || volumeHeld)
+			m_reactor->wait(BUSY_TICK_MS);
+		else
+			m_reactor->wait();
 	}
 
 #if defined(USE_HAMLIB)
@@ -479,12 +661,16 @@ int CM17Client::run()
 
 	m_socket->close();
 	m_sound->close();
+	m_dsp->close();
+	m_reactor->close();
 	m_modem->close();
 
 	delete m_codePlug;
+	delete m_dsp;
 	delete m_tx;
 	delete m_rx;
 	delete m_socket;
+	delete m_reactor;
 	delete m_modem;
 
 	::LogFinalise();
@@ -634,13 +820,6 @@ void CM17Client::sendDestinationList()
 
 void CM17Client::statusCallback(const std::string& source, const std::string& dest, bool end)
 {
-	assert(m_socket != NULL);
-
-#if defined(USE_GPIO)
-	if (m_gpio != NULL)
-		m_gpio->setRCV(!end);
-#endif
-
 	char buffer[50U];
 	::strcpy(buffer, "RX");
 	::strcat(buffer, DELIMITER);
@@ -650,12 +829,11 @@ void CM17Client::statusCallback(const std::string& source, const std::string& de
 	::strcat(buffer, DELIMITER);
 	::strcat(buffer, dest.c_str());
 
-	m_socket->write(buffer, ::strlen(buffer), m_sockaddr, m_sockaddrLen);
+	writeRXEvent(end ? RX_EVENT_END : RX_EVENT_START, buffer);
 }
 
 void CM17Client::textCallback(const char* text)
 {
-	assert(m_socket != NULL);
 	assert(text != NULL);
 
 	char buffer[50U];
@@ -663,19 +841,17 @@ void CM17Client::textCallback(const char* text)
 	::strcat(buffer, DELIMITER);
 	::strcat(buffer, text);
 
-	m_socket->write(buffer, ::strlen(buffer), m_sockaddr, m_sockaddrLen);
+	writeRXEvent(RX_EVENT_REPORT, buffer);
 }
 
 void CM17Client::rssiCallback(int rssi)
 {
-	assert(m_socket != NULL);
-
 	char buffer[50U];
 	::strcpy(buffer, "RSSI");
 	::strcat(buffer, DELIMITER);
 	::sprintf(buffer + ::strlen(buffer), "%d", rssi);
 
-	m_socket->write(buffer, ::strlen(buffer), m_sockaddr, m_sockaddrLen);
+	writeRXEvent(RX_EVENT_REPORT, buffer);
 }
 
 void CM17Client::gpsCallback(float latitude, float longitude, const std::string& locator,
@@ -683,8 +859,6 @@ void CM17Client::gpsCallback(float latitude, float longitude, const std::string&
 		const std::optional<float>& speed, const std::optional<float>& track,
 		const std::optional<float>& bearing, const std::optional<float>& distance)
 {
-	assert(m_socket != NULL);
-
 	char buffer[200U];
 	::strcpy(buffer, "GPS");
 	::strcat(buffer, DELIMITER);
@@ -709,12 +883,11 @@ void CM17Client::gpsCallback(float latitude, float longitude, const std::string&
 	if (distance)
 		::sprintf(buffer + ::strlen(buffer), "%f", distance.value());
 
-	m_socket->write(buffer, ::strlen(buffer), m_sockaddr, m_sockaddrLen);
+	writeRXEvent(RX_EVENT_REPORT, buffer);
 }
 
 void CM17Client::callsignsCallback(const char* callsigns)
 {
-	assert(m_socket != NULL);
 	assert(callsigns != NULL);
 
 	char buffer[100U];
@@ -722,6 +895,46 @@ void CM17Client::callsignsCallback(const char* callsigns)
 	::strcat(buffer, DELIMITER);
 	::strcat(buffer, callsigns);
 
-	m_socket->write(buffer, ::strlen(buffer), m_sockaddr, m_sockaddrLen);
+	writeRXEvent(RX_EVENT_REPORT, buffer);
+}
+
+void CM17Client::writeRXEvent(unsigned char type, const char* text)
+{
+	assert(text != NULL);
+	assert(m_reactor != NULL);
+
+	unsigned int len = ::strlen(text);
+	assert(len <= RX_EVENT_MAX_TEXT);
+
+	// One record so that the main loop never sees half of one
+	unsigned char record[2U + RX_EVENT_MAX_TEXT];
+	record[0U] = type;
+	record[1U] = len;
+	::memcpy(record + 2U, text, len);
+
+	if (m_rxEvents.addData(record, 2U + len))
+		m_reactor->notify();
 }
 
+void CM17Client::processRXEvents()
+{
+	assert(m_socket != NULL);
+
+	while (!m_rxEvents.isEmpty()) {
+		unsigned char type = RX_EVENT_REPORT;
+		m_rxEvents.getData(&type, 1U);
+
+		unsigned char len = 0U;
+		m_rxEvents.getData(&len, 1U);
+
+		char buffer[RX_EVENT_MAX_TEXT];
+		m_rxEvents.getData((unsigned char*)buffer, len);
+
+#if defined(USE_GPIO)
+		if (m_gpio != NULL && type != RX_EVENT_REPORT)
+			m_gpio->setRCV(type == RX_EVENT_START);
+#endif
+
+		m_socket->write(buffer, len, m_sockaddr, m_sockaddrLen);
+	}
+}
@@ -22,7 +22,9 @@
 #include "StatusCallback.h"
 #include "AudioBackend.h"
 #include "AudioCallback.h"
+#include "SPSCRingBuffer.h"
 #include "UDPSocket.h"
+#include "Reactor.h"
 #if defined(USE_HAMLIB)
 #include "HamLib.h"
 #endif
@@ -32,6 +34,7 @@
 #if defined(USE_GPIO)
 #include "GPIO.h"
 #endif
+#include "DSPWorker.h"
 #include "CodePlug.h"
 #include "M17RX.h"
 #include "M17TX.h"
@@ -50,6 +53,8 @@ public:
 	virtual void readCallback(const float* input, unsigned int nSamples, int id);
 	virtual void writeCallback(float* output, int& nSamples, int id);
 
+	// The status callbacks come from the DSP worker thread, they queue the
+	// reports for the main loop to send
 	virtual void statusCallback(const std::string& source, const std::string& dest, bool end);
 	virtual void textCallback(const char* text);
 	virtual void rssiCallback(int rssi);
@@ -69,6 +74,9 @@ private:
 	bool             m_tx2;
 	IAudioBackend*   m_sound;
 	CUDPSocket*      m_socket;
+	CReactor*        m_reactor;
+	CDSPWorker*      m_dsp;
+	CSPSCRingBuffer<unsigned char> m_rxEvents;
 #if defined(USE_HAMLIB)
 	CHamLib*         m_hamLib;
 #endif
@@ -89,6 +97,9 @@ private:
 	void sendDestinationList();
 
 	bool processChannelRequest(const char* channel);
+
+	void writeRXEvent(unsigned char type, const char* text);
+	void processRXEvents();
 };
 
 #endif
@@ -23,6 +23,12 @@
 #include <cstring>
 #include <cstdlib>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
 const unsigned int PUNCTURE_LIST_LINK_SETUP_COUNT = 60U;
 
 const unsigned int PUNCTURE_LIST_LINK_SETUP[] = {
@@ -33,12 +39,16 @@ const unsigned int PUNCTURE_LIST_LINK_SETUP[] = {
 	343U, 347U, 351U, 355U, 359U, 363U, 368U, 372U, 376U, 380U, 384U, 388U, 392U, 396U, 400U, 404U, 408U, 412U, 416U, 420U, 424U,
 	429U, 433U, 437U, 441U, 445U, 449U, 453U, 457U, 461U, 465U, 469U, 473U, 477U, 481U, 485U};
 
+const unsigned int PUNCTURE_LIST_LINK_SETUP_LENGTH = sizeof(PUNCTURE_LIST_LINK_SETUP) / sizeof(unsigned int);
+
 const unsigned int PUNCTURE_LIST_DATA_COUNT = 12U;
 
 const unsigned int PUNCTURE_LIST_DATA[] = {
 	 11U,  23U,  35U,  47U,  59U,  71U,  83U,  95U, 107U, 119U, 131U, 143U, 155U, 167U, 179U, 191U, 203U, 215U, 227U, 239U, 251U,
 	263U, 275U, 287U};
 
+const unsigned int PUNCTURE_LIST_DATA_LENGTH = sizeof(PUNCTURE_LIST_DATA) / sizeof(unsigned int);
+
 const unsigned char BIT_MASK_TABLE[] = {0x80U, 0x40U, 0x20U, 0x10U, 0x08U, 0x04U, 0x02U, 0x01U};
 
 #define WRITE_BIT1(p,i,b) p[(i)>>3] = (b) ? (p[(i)>>3] | BIT_MASK_TABLE[(i)&7]) : (p[(i)>>3] & ~BIT_MASK_TABLE[(i)&7])
@@ -47,29 +57,30 @@ const unsigned char BIT_MASK_TABLE[] = {0x80U, 0x40U, 0x20U, 0x10U, 0x08U, 0x04U
 const uint8_t BRANCH_TABLE1[] = {0U, 0U, 0U, 0U, 2U, 2U, 2U, 2U};
 const uint8_t BRANCH_TABLE2[] = {0U, 2U, 2U, 0U, 0U, 2U, 2U, 0U};
 
+// Soft symbols are scaled by two so that an erasure sits exactly half way
+const uint16_t SOFT_BRANCH_TABLE1[] = {0U, 0U, 0U, 0U, 510U, 510U, 510U, 510U};
+const uint16_t SOFT_BRANCH_TABLE2[] = {0U, 510U, 510U, 0U, 0U, 510U, 510U, 0U};
+const uint16_t SOFT_ERASURE = 255U;
+const uint32_t SOFT_M = 1020U;
+
 const unsigned int NUM_OF_STATES_D2 = 8U;
-const unsigned int NUM_OF_STATES = 16U;
+const unsigned int NUM_OF_STATES = M17_CONVOLUTION_STATES;
 const uint32_t     M = 4U;
 const unsigned int K = 5U;
 
 CM17Convolution::CM17Convolution() :
-m_metrics1(NULL),
-m_metrics2(NULL),
-m_oldMetrics(NULL),
-m_newMetrics(NULL),
-m_decisions(NULL),
-m_dp(NULL)
+m_metrics1(),
+m_metrics2(),
+m_oldMetrics(m_metrics1),
+m_newMetrics(m_metrics2),
+m_decisions(),
+m_dp(m_decisions),
+m_simd(hasSIMD())
 {
-	m_metrics1  = new uint16_t[20U];
-	m_metrics2  = new uint16_t[20U];
-	m_decisions = new uint64_t[300U];
 }
 
 CM17Convolution::~CM17Convolution()
 {
-	delete[] m_metrics1;
-	delete[] m_metrics2;
-	delete[] m_decisions;
 }
 
 void CM17Convolution::encodeLinkSetup(const unsigned char* in, unsigned char* out) const
@@ -87,7 +98,7 @@ void CM17Convolution::encodeLinkSetup(const unsigned char* in, unsigned char* ou
 	unsigned int n = 0U;
 	unsigned int index = 0U;
 	for (unsigned int i = 0U; i < 488U; i++) {
-		if (i != PUNCTURE_LIST_LINK_SETUP[index]) {
+		if (index >= PUNCTURE_LIST_LINK_SETUP_LENGTH || i != PUNCTURE_LIST_LINK_SETUP[index]) {
 			bool b = READ_BIT1(temp2, i);
 			WRITE_BIT1(out, n, b);
 			n++;
@@ -112,7 +123,7 @@ void CM17Convolution::encodeData(const unsigned char* in, unsigned char* out) co
 	unsigned int n = 0U;
 	unsigned int index = 0U;
 	for (unsigned int i = 0U; i < 296U; i++) {
-		if (i != PUNCTURE_LIST_DATA[index]) {
+		if (index >= PUNCTURE_LIST_DATA_LENGTH || i != PUNCTURE_LIST_DATA[index]) {
 			bool b = READ_BIT1(temp2, i);
 			WRITE_BIT1(out, n, b);
 			n++;
@@ -133,7 +144,7 @@ unsigned int CM17Convolution::decodeLinkSetup(const unsigned char* in, unsigned
 	unsigned int n = 0U;
 	unsigned int index = 0U;
 	for (unsigned int i = 0U; i < 368U; i++) {
-		if (n == PUNCTURE_LIST_LINK_SETUP[index]) {
+		if (index < PUNCTURE_LIST_LINK_SETUP_LENGTH && n == PUNCTURE_LIST_LINK_SETUP[index]) {
 			temp[n++] = 1U;
 			index++;
 		}
@@ -144,13 +155,7 @@ unsigned int CM17Convolution::decodeLinkSetup(const unsigned char* in, unsigned
 
 	start();
 
-	n = 0U;
-	for (unsigned int i = 0U; i < 244U; i++) {
-		uint8_t s0 = temp[n++];
-		uint8_t s1 = temp[n++];
-
-		decode(s0, s1);
-	}
+	decode(temp, 244U);
 
 	return chainback(out, 240U) - PUNCTURE_LIST_LINK_SETUP_COUNT;
 }
@@ -166,7 +171,7 @@ unsigned int CM17Convolution::decodeData(const unsigned char* in, unsigned char*
 	unsigned int n = 0U;
 	unsigned int index = 0U;
 	for (unsigned int i = 0U; i < 272U; i++) {
-		if (n == PUNCTURE_LIST_DATA[index]) {
+		if (index < PUNCTURE_LIST_DATA_LENGTH && n == PUNCTURE_LIST_DATA[index]) {
 			temp[n++] = 1U;
 			index++;
 		}
@@ -177,19 +182,84 @@ unsigned int CM17Convolution::decodeData(const unsigned char* in, unsigned char*
 
 	start();
 
-	n = 0U;
-	for (unsigned int i = 0U; i < 148U; i++) {
-		uint8_t s0 = temp[n++];
-		uint8_t s1 = temp[n++];
+	decode(temp, 148U);
+
+	return chainback(out, 144U) - PUNCTURE_LIST_DATA_COUNT;
+}
+
+unsigned int CM17Convolution::decodeLinkSetupSoft(const uint8_t* in, unsigned char* out)
+{
+	assert(in != NULL);
+	assert(out != NULL);
+
+	uint16_t temp[500U];
+	depunctureSoft(in, 368U, PUNCTURE_LIST_LINK_SETUP, PUNCTURE_LIST_LINK_SETUP_LENGTH, temp);
+
+	decodeSoft(temp, 244U);
+
+	traceback(out, 240U);
+
+	unsigned char encoded[46U];
+	encodeLinkSetup(out, encoded);
 
-		decode(s0, s1);
+	return countErrors(in, encoded, 368U);
+}
+
+unsigned int CM17Convolution::decodeDataSoft(const uint8_t* in, unsigned char* out)
+{
+	assert(in != NULL);
+	assert(out != NULL);
+
+	uint16_t temp[300U];
+	depunctureSoft(in, 272U, PUNCTURE_LIST_DATA, PUNCTURE_LIST_DATA_LENGTH, temp);
+
+	decodeSoft(temp, 148U);
+
+	traceback(out, 144U);
+
+	unsigned char encoded[34U];
+	encodeData(out, encoded);
+
+	return countErrors(in, encoded, 272U);
+}
+
+void CM17Convolution::depunctureSoft(const uint8_t* in, unsigned int nIn, const unsigned int* list, unsigned int listLength, uint16_t* out) const
+{
+	assert(in != NULL);
+	assert(list != NULL);
+	assert(out != NULL);
+
+	unsigned int n = 0U;
+	unsigned int index = 0U;
+	for (unsigned int i = 0U; i < nIn; i++) {
+		if (index < listLength && n == list[index]) {
+			out[n++] = SOFT_ERASURE;
+			index++;
+		}
+
+		out[n++] = uint16_t(in[i]) * 2U;
 	}
+}
 
-	return chainback(out, 144U) - PUNCTURE_LIST_DATA_COUNT;
+unsigned int CM17Convolution::countErrors(const uint8_t* in, const unsigned char* encoded, unsigned int nBits) const
+{
+	assert(in != NULL);
+	assert(encoded != NULL);
+
+	unsigned int errs = 0U;
+	for (unsigned int i = 0U; i < nBits; i++) {
+		bool b1 = in[i] >= 0x80U;
+		bool b2 = READ_BIT1(encoded, i) != 0U;
+		if (b1 != b2)
+			errs++;
+	}
+
+	return errs;
 }
 
 void CM17Convolution::start()
 {
+	// Only the starting metrics need clearing, the decisions are overwritten as we go
 	::memset(m_metrics1, 0x00U, NUM_OF_STATES * sizeof(uint16_t));
 	::memset(m_metrics2, 0x00U, NUM_OF_STATES * sizeof(uint16_t));
 
@@ -198,6 +268,141 @@ void CM17Convolution::start()
 	m_dp = m_decisions;
 }
 
+void CM17Convolution::setSIMD(bool on)
+{
+	m_simd = on && hasSIMD();
+}
+
+bool CM17Convolution::getSIMD() const
+{
+	return m_simd;
+}
+
+bool CM17Convolution::hasSIMD()
+{
+	// SSE2 is part of x86-64 and a NEON build already assumes NEON
+	// throughout, so this is decided when compiling
+#if defined(__SSE2__) || defined(__ARM_NEON)
+	return true;
+#else
+	return false;
+#endif
+}
+
+void CM17Convolution::decode(const uint8_t* symbols, unsigned int nSteps)
+{
+	assert(symbols != NULL);
+	assert(nSteps <= M17_CONVOLUTION_DECISIONS);
+
+#if defined(__SSE2__) || defined(__ARM_NEON)
+	if (m_simd) {
+		decodeSIMD(symbols, nSteps);
+		return;
+	}
+#endif
+
+	for (unsigned int i = 0U; i < nSteps; i++, symbols += 2U)
+		decode(symbols[0U], symbols[1U]);
+}
+
+#if defined(__SSE2__)
+/*
+ * All 16 states in two vectors, the old metrics for states 0-7 in one and
+ * 8-15 in the other. Each lane i is butterfly i which produces new states
+ * 2i and 2i+1, so the even and odd results are interleaved back into state
+ * order for the next step. A decision is set when the path from the upper
+ * half of the old states wins, the same rule as the scalar version.
+ */
+void CM17Convolution::decodeSIMD(const uint8_t* symbols, unsigned int nSteps)
+{
+	const __m128i branch1 = _mm_setr_epi16(0, 0, 0, 0, 2, 2, 2, 2);
+	const __m128i branch2 = _mm_setr_epi16(0, 2, 2, 0, 0, 2, 2, 0);
+	const __m128i maximum = _mm_set1_epi16(M);
+	const __m128i zero    = _mm_setzero_si128();
+
+	__m128i lower = _mm_loadu_si128((const __m128i*)(m_oldMetrics + 0U));
+	__m128i upper = _mm_loadu_si128((const __m128i*)(m_oldMetrics + NUM_OF_STATES_D2));
+
+	for (unsigned int i = 0U; i < nSteps; i++, symbols += 2U) {
+		__m128i diff0 = _mm_sub_epi16(branch1, _mm_set1_epi16(symbols[0U]));
+		__m128i diff1 = _mm_sub_epi16(branch2, _mm_set1_epi16(symbols[1U]));
+
+		__m128i metric  = _mm_add_epi16(_mm_max_epi16(diff0, _mm_sub_epi16(zero, diff0)), _mm_max_epi16(diff1, _mm_sub_epi16(zero, diff1)));
+		__m128i inverse = _mm_sub_epi16(maximum, metric);
+
+		__m128i m0 = _mm_add_epi16(lower, metric);
+		__m128i m1 = _mm_add_epi16(upper, inverse);
+		__m128i even         = _mm_min_epi16(m0, m1);
+		__m128i evenDecision = _mm_cmpeq_epi16(even, m1);
+
+		m0 = _mm_add_epi16(lower, inverse);
+		m1 = _mm_add_epi16(upper, metric);
+		__m128i odd         = _mm_min_epi16(m0, m1);
+		__m128i oddDecision = _mm_cmpeq_epi16(odd, m1);
+
+		lower = _mm_unpacklo_epi16(even, odd);
+		upper = _mm_unpackhi_epi16(even, odd);
+
+		__m128i decisions = _mm_packs_epi16(_mm_unpacklo_epi16(evenDecision, oddDecision), _mm_unpackhi_epi16(evenDecision, oddDecision));
+
+		*m_dp++ = uint64_t(_mm_movemask_epi8(decisions));
+	}
+
+	_mm_storeu_si128((__m128i*)(m_oldMetrics + 0U), lower);
+	_mm_storeu_si128((__m128i*)(m_oldMetrics + NUM_OF_STATES_D2), upper);
+}
+#elif defined(__ARM_NEON)
+/*
+ * See the SSE2 version for the layout. NEON has no movemask so the decision
+ * bytes are weighted by their bit position and summed pairwise.
+ */
+void CM17Convolution::decodeSIMD(const uint8_t* symbols, unsigned int nSteps)
+{
+	const uint16_t BRANCH1[] = {0U, 0U, 0U, 0U, 2U, 2U, 2U, 2U};
+	const uint16_t BRANCH2[] = {0U, 2U, 2U, 0U, 0U, 2U, 2U, 0U};
+	const uint8_t  WEIGHTS[] = {0x01U, 0x02U, 0x04U, 0x08U, 0x10U, 0x20U, 0x40U, 0x80U, 0x01U, 0x02U, 0x04U, 0x08U, 0x10U, 0x20U, 0x40U, 0x80U};
+
+	const uint16x8_t branch1 = vld1q_u16(BRANCH1);
+	const uint16x8_t branch2 = vld1q_u16(BRANCH2);
+	const uint16x8_t maximum = vdupq_n_u16(M);
+	const uint8x16_t weights = vld1q_u8(WEIGHTS);
+
+	uint16x8_t lower = vld1q_u16(m_oldMetrics + 0U);
+	uint16x8_t upper = vld1q_u16(m_oldMetrics + NUM_OF_STATES_D2);
+
+	for (unsigned int i = 0U; i < nSteps; i++, symbols += 2U) {
+		uint16x8_t metric  = vaddq_u16(vabdq_u16(branch1, vdupq_n_u16(symbols[0U])), vabdq_u16(branch2, vdupq_n_u16(symbols[1U])));
+		uint16x8_t inverse = vsubq_u16(maximum, metric);
+
+		uint16x8_t m0 = vaddq_u16(lower, metric);
+		uint16x8_t m1 = vaddq_u16(upper, inverse);
+		uint16x8_t even         = vminq_u16(m0, m1);
+		uint16x8_t evenDecision = vcgeq_u16(m0, m1);
+
+		m0 = vaddq_u16(lower, inverse);
+		m1 = vaddq_u16(upper, metric);
+		uint16x8_t odd         = vminq_u16(m0, m1);
+		uint16x8_t oddDecision = vcgeq_u16(m0, m1);
+
+		uint16x8x2_t metrics = vzipq_u16(even, odd);
+		lower = metrics.val[0U];
+		upper = metrics.val[1U];
+
+		uint16x8x2_t decisions = vzipq_u16(evenDecision, oddDecision);
+		uint8x16_t bits = vandq_u8(vcombine_u8(vmovn_u16(decisions.val[0U]), vmovn_u16(decisions.val[1U])), weights);
+
+		uint8x8_t sum = vpadd_u8(vget_low_u8(bits), vget_high_u8(bits));
+		sum = vpadd_u8(sum, sum);
+		sum = vpadd_u8(sum, sum);
+
+		*m_dp++ = uint64_t(vget_lane_u8(sum, 0)) | (uint64_t(vget_lane_u8(sum, 1)) << 8);
+	}
+
+	vst1q_u16(m_oldMetrics + 0U, lower);
+	vst1q_u16(m_oldMetrics + NUM_OF_STATES_D2, upper);
+}
+#endif
+
 void CM17Convolution::decode(uint8_t s0, uint8_t s1)
 {
   *m_dp = 0U;
@@ -222,28 +427,65 @@ void CM17Convolution::decode(uint8_t s0, uint8_t s1)
 
   ++m_dp;
 
-  assert((m_dp - m_decisions) <= 300);
+  assert((m_dp - m_decisions) <= int(M17_CONVOLUTION_DECISIONS));
 
   uint16_t* tmp = m_oldMetrics;
   m_oldMetrics = m_newMetrics;
   m_newMetrics = tmp;
 }
 
-unsigned int CM17Convolution::chainback(unsigned char* out, unsigned int nBits)
+/*
+ * The same trellis as decode() but with the wider soft symbols, so the path
+ * metrics need 32 bits.
+ */
+void CM17Convolution::decodeSoft(const uint16_t* symbols, unsigned int nSteps)
 {
-	assert(out != NULL);
+	assert(symbols != NULL);
+	assert(nSteps <= M17_CONVOLUTION_DECISIONS);
 
-	uint32_t state = 0U;
+	uint32_t metrics1[NUM_OF_STATES];
+	uint32_t metrics2[NUM_OF_STATES];
+	::memset(metrics1, 0x00U, NUM_OF_STATES * sizeof(uint32_t));
 
-	while (nBits-- > 0) {
-		--m_dp;
+	uint32_t* oldMetrics = metrics1;
+	uint32_t* newMetrics = metrics2;
 
-		uint32_t  i = state >> (9 - K);
-		uint8_t bit = uint8_t(*m_dp >> i) & 1;
-		state = (bit << 7) | (state >> 1);
+	m_dp = m_decisions;
 
-		WRITE_BIT1(out, nBits, bit != 0U);
+	for (unsigned int n = 0U; n < nSteps; n++, symbols += 2U) {
+		uint64_t decisions = 0U;
+
+		for (unsigned int i = 0U; i < NUM_OF_STATES_D2; i++) {
+			unsigned int j = i * 2U;
+
+			uint32_t metric = std::abs(int(SOFT_BRANCH_TABLE1[i]) - int(symbols[0U])) + std::abs(int(SOFT_BRANCH_TABLE2[i]) - int(symbols[1U]));
+
+			uint32_t m0 = oldMetrics[i] + metric;
+			uint32_t m1 = oldMetrics[i + NUM_OF_STATES_D2] + (SOFT_M - metric);
+			uint64_t decision0 = (m0 >= m1) ? 1U : 0U;
+			newMetrics[j + 0U] = decision0 != 0U ? m1 : m0;
+
+			m0 = oldMetrics[i] + (SOFT_M - metric);
+			m1 = oldMetrics[i + NUM_OF_STATES_D2] + metric;
+			uint64_t decision1 = (m0 >= m1) ? 1U : 0U;
+			newMetrics[j + 1U] = decision1 != 0U ? m1 : m0;
+
+			decisions |= (decision1 << (j + 1U)) | (decision0 << (j + 0U));
+		}
+
+		*m_dp++ = decisions;
+
+		uint32_t* tmp = oldMetrics;
+		oldMetrics = newMetrics;
+		newMetrics = tmp;
 	}
+}
+
+unsigned int CM17Convolution::chainback(unsigned char* out, unsigned int nBits)
+{
+	assert(out != NULL);
+
+	traceback(out, nBits);
 
 	unsigned int minCost = m_oldMetrics[0];
 
@@ -255,6 +497,23 @@ unsigned int CM17Convolution::chainback(unsigned char* out, unsigned int nBits)
 	return minCost / (M >> 1);
 }
 
+void CM17Convolution::traceback(unsigned char* out, unsigned int nBits)
+{
+	assert(out != NULL);
+
+	uint32_t state = 0U;
+
+	while (nBits-- > 0) {
+		--m_dp;
+
+		uint32_t  i = state >> (9 - K);
+		uint8_t bit = uint8_t(*m_dp >> i) & 1;
+		state = (bit << 7) | (state >> 1);
+
+		WRITE_BIT1(out, nBits, bit != 0U);
+	}
+}
+
 void CM17Convolution::encode(const unsigned char* in, unsigned char* out, unsigned int nBits) const
 {
 	assert(in != NULL);
@@ -21,6 +21,9 @@
 
 #include <cstdint>
 
+const unsigned int M17_CONVOLUTION_STATES    = 16U;
+const unsigned int M17_CONVOLUTION_DECISIONS = 300U;
+
 class CM17Convolution {
 public:
 	CM17Convolution();
@@ -29,21 +32,44 @@ public:
 	unsigned int decodeLinkSetup(const unsigned char* in, unsigned char* out);
 	unsigned int decodeData(const unsigned char* in, unsigned char* out);
 
+	// Soft bits, one per byte, run from 0x00 for a certain 0 to 0xFF for a
+	// certain 1. The returned BER is the number of hard decisions that differ
+	// from the re-encoded output.
+	unsigned int decodeLinkSetupSoft(const uint8_t* in, unsigned char* out);
+	unsigned int decodeDataSoft(const uint8_t* in, unsigned char* out);
+
 	void encodeLinkSetup(const unsigned char* in, unsigned char* out) const;
 	void encodeData(const unsigned char* in, unsigned char* out) const;
 
+	// Use the vectorised add-compare-select when it is compiled in, the
+	// default, or force the scalar reference version, see M17ConvolutionTest
+	void setSIMD(bool on);
+	bool getSIMD() const;
+
+	static bool hasSIMD();
+
 private:
-	uint16_t* m_metrics1;
-	uint16_t* m_metrics2;
+	uint16_t  m_metrics1[M17_CONVOLUTION_STATES];
+	uint16_t  m_metrics2[M17_CONVOLUTION_STATES];
 	uint16_t* m_oldMetrics;
 	uint16_t* m_newMetrics;
-	uint64_t* m_decisions;
+	uint64_t  m_decisions[M17_CONVOLUTION_DECISIONS];
 	uint64_t* m_dp;
+	bool      m_simd;
 
 	void start();
+	void decode(const uint8_t* symbols, unsigned int nSteps);
 	void decode(uint8_t s0, uint8_t s1);
+	void decodeSoft(const uint16_t* symbols, unsigned int nSteps);
+#if defined(__SSE2__) || defined(__ARM_NEON)
+	void decodeSIMD(const uint8_t* symbols, unsigned int nSteps);
+#endif
 
 	unsigned int chainback(unsigned char* out, unsigned int nBits);
+	void traceback(unsigned char* out, unsigned int nBits);
+
+	void depunctureSoft(const uint8_t* in, unsigned int nIn, const unsigned int* list, unsigned int listLength, uint16_t* out) const;
+	unsigned int countErrors(const uint8_t* in, const unsigned char* encoded, unsigned int nBits) const;
 
 	void encode(const unsigned char* in, unsigned char* out, unsigned int nBits) const;
 };
@@ -0,0 +1,155 @@
+/*
+ *   Copyright (C) 2022 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include "M17Convolution.h"
+#include "TestUtils.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+const unsigned int RUNS = 20000U;
+
+const unsigned char BIT_MASK_TABLE[] = {0x80U, 0x40U, 0x20U, 0x10U, 0x08U, 0x04U, 0x02U, 0x01U};
+
+// Link setup is 240 bits coded to 368, stream data 144 bits to 272
+const unsigned int LSF_IN_BYTES   = 30U;
+const unsigned int LSF_OUT_BYTES  = 46U;
+const unsigned int DATA_IN_BYTES  = 18U;
+const unsigned int DATA_OUT_BYTES = 34U;
+
+// Flip each bit with a probability of rate / 1000, and sometimes fill the
+// frame with noise so the decoders see input that isn't a codeword
+static void corrupt(unsigned char* data, unsigned int len, unsigned int rate)
+{
+	if ((::rand() % 20) == 0) {
+		CTestUtils::randomBytes(data, len);
+		return;
+	}
+
+	for (unsigned int i = 0U; i < len * 8U; i++) {
+		if (unsigned(::rand() % 1000) < rate)
+			data[i >> 3] ^= BIT_MASK_TABLE[i & 7];
+	}
+}
+
+static unsigned int check(const char* name, unsigned int inBytes, unsigned int outBytes,
+		void (CM17Convolution::*encode)(const unsigned char*, unsigned char*) const,
+		unsigned int (CM17Convolution::*decode)(const unsigned char*, unsigned char*))
+{
+	CM17Convolution simd;
+	CM17Convolution scalar;
+	scalar.setSIMD(false);
+
+	unsigned int failures = 0U;
+
+	for (unsigned int n = 0U; n < RUNS; n++) {
+		unsigned char data[LSF_IN_BYTES];
+		CTestUtils::randomBytes(data, inBytes);
+
+		unsigned char coded[LSF_OUT_BYTES];
+		(simd.*encode)(data, coded);
+
+		corrupt(coded, outBytes, n % 150U);
+
+		unsigned char out1[LSF_IN_BYTES];
+		unsigned char out2[LSF_IN_BYTES];
+		::memset(out1, 0x00U, LSF_IN_BYTES);
+		::memset(out2, 0x00U, LSF_IN_BYTES);
+
+		unsigned int ber1 = (simd.*decode)(coded, out1);
+		unsigned int ber2 = (scalar.*decode)(coded, out2);
+
+		if (ber1 != ber2 || ::memcmp(out1, out2, inBytes) != 0) {
+			if (failures == 0U)
+				::fprintf(stderr, "M17ConvolutionTest: %s differs on run %u, BER %u and %u\n", name, n, ber1, ber2);
+			failures++;
+		}
+	}
+
+	CTestUtils::report(name, RUNS, failures);
+
+	return failures;
+}
+
+// Soft bits on the right side of 0x80 with a random confidence must decode
+// with a BER of 0. Two weakly wrong bits well apart must be corrected and
+// counted, the right bits are kept away from erasures so that this is
+// always the most likely path.
+static unsigned int checkSoft(const char* name, unsigned int inBytes, unsigned int outBytes,
+		void (CM17Convolution::*encode)(const unsigned char*, unsigned char*) const,
+		unsigned int (CM17Convolution::*decode)(const uint8_t*, unsigned char*))
+{
+	CM17Convolution conv;
+
+	unsigned int failures = 0U;
+
+	for (unsigned int n = 0U; n < RUNS; n++) {
+		unsigned char data[LSF_IN_BYTES];
+		CTestUtils::randomBytes(data, inBytes);
+
+		unsigned char coded[LSF_OUT_BYTES];
+		(conv.*encode)(data, coded);
+
+		uint8_t soft[LSF_OUT_BYTES * 8U];
+		for (unsigned int i = 0U; i < outBytes * 8U; i++) {
+			uint8_t confidence = 32U + (::rand() % 96);
+			soft[i] = (coded[i >> 3] & BIT_MASK_TABLE[i & 7]) ? 0x80U + confidence : 0x7FU - confidence;
+		}
+
+		unsigned int expected = 0U;
+		if ((n % 2U) == 1U) {
+			unsigned int pos = ::rand() % (outBytes * 8U - 120U);
+			soft[pos]        = soft[pos] >= 0x80U ? 0x70U : 0x90U;
+			soft[pos + 100U] = soft[pos + 100U] >= 0x80U ? 0x70U : 0x90U;
+			expected = 2U;
+		}
+
+		unsigned char out[LSF_IN_BYTES];
+		::memset(out, 0x00U, LSF_IN_BYTES);
+
+		unsigned int ber = (conv.*decode)(soft, out);
+
+		if (ber != expected || ::memcmp(out, data, inBytes) != 0) {
+			if (failures == 0U)
+				::fprintf(stderr, "M17ConvolutionTest: %s failed on run %u, BER %u expected %u\n", name, n, ber, expected);
+			failures++;
+		}
+	}
+
+	CTestUtils::report(name, RUNS, failures);
+
+	return failures;
+}
+
+int main(int argc, char** argv)
+{
+	CTestUtils::seed(argc, argv);
+
+	CM17Convolution conv;
+	if (!conv.getSIMD())
+		::fprintf(stdout, "M17ConvolutionTest: no SIMD version in this build, comparing the scalar version with itself\n");
+
+	unsigned int failures = 0U;
+	failures += check("decodeLinkSetup", LSF_IN_BYTES, LSF_OUT_BYTES, &CM17Convolution::encodeLinkSetup, &CM17Convolution::decodeLinkSetup);
+	failures += check("decodeData", DATA_IN_BYTES, DATA_OUT_BYTES, &CM17Convolution::encodeData, &CM17Convolution::decodeData);
+	failures += checkSoft("decodeLinkSetupSoft", LSF_IN_BYTES, LSF_OUT_BYTES, &CM17Convolution::encodeLinkSetup, &CM17Convolution::decodeLinkSetupSoft);
+	failures += checkSoft("decodeDataSoft", DATA_IN_BYTES, DATA_OUT_BYTES, &CM17Convolution::encodeData, &CM17Convolution::decodeDataSoft);
+
+	return failures == 0U ? 0 : 1;
+}
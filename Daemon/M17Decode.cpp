@@ -0,0 +1,416 @@
+/*
+ *   Copyright (C) 2022 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include "M17Decode.h"
+#include "M17Defines.h"
+#include "GitVersion.h"
+#include "Defines.h"
+#include "Version.h"
+#include "Log.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cassert>
+#include <cctype>
+#include <cerrno>
+#include <ctime>
+#include <vector>
+
+const unsigned int MAX_FRAME_LENGTH = 255U;
+
+const unsigned char MMDVM_FRAME_START = 0xE0U;
+
+static unsigned long long nowNS()
+{
+	struct timespec now;
+	::clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+int main(int argc, char** argv)
+{
+	bool trace = false;
+	bool soft = false;
+	bool debug = false;
+	std::string rssi;
+	std::vector<std::string> files;
+
+	for (int currentArg = 1; currentArg < argc; ++currentArg) {
+		std::string arg = argv[currentArg];
+		if ((arg == "-v") || (arg == "--version")) {
+			::fprintf(stdout, "M17Decode version %s git #%.7s\n", VERSION, gitversion);
+			return 0;
+		} else if ((arg == "-T") || (arg == "--trace")) {
+			trace = true;
+		} else if ((arg == "-S") || (arg == "--soft")) {
+			soft = true;
+		} else if ((arg == "-D") || (arg == "--debug")) {
+			debug = true;
+		} else if (((arg == "-r") || (arg == "--rssi")) && (currentArg + 1) < argc) {
+			rssi = argv[++currentArg];
+		} else if (arg.substr(0,1) == "-") {
+			files.clear();
+			break;
+		} else {
+			files.push_back(arg);
+		}
+	}
+
+	if (files.size() != 3U || (trace && soft)) {
+		::fprintf(stderr, "Usage: M17Decode [-v|--version] [-T|--trace | -S|--soft] [-D|--debug] [-r|--rssi <file>] <capture> <audio.wav> <metadata.json>\n");
+		return 1;
+	}
+
+	// Log to the display only
+	::LogInitialise(false, "", "", 0U, debug ? 1U : 2U, false);
+
+	CM17Decode* decode = new CM17Decode(files.at(0U), files.at(1U), files.at(2U), trace, soft, rssi);
+	int ret = decode->run();
+
+	delete decode;
+
+	::LogFinalise();
+
+	return ret;
+}
+
+CM17Decode::CM17Decode(const std::string& input, const std::string& audio, const std::string& metadata, bool trace, bool soft, const std::string& rssi) :
+m_input(input),
+m_audio(audio),
+m_metadata(metadata),
+m_trace(trace),
+m_soft(soft),
+m_rssi(rssi),
+m_in(NULL),
+m_json(NULL),
+m_wav(NULL),
+m_rssiMapper(),
+m_frames(0U),
+m_events(0U)
+{
+}
+
+CM17Decode::~CM17Decode()
+{
+}
+
+int CM17Decode::run()
+{
+	m_in = ::fopen(m_input.c_str(), m_trace ? "rt" : "rb");
+	if (m_in == NULL) {
+		LogError("Cannot open the capture file - %s, errno=%d", m_input.c_str(), errno);
+		return 1;
+	}
+
+	m_json = ::fopen(m_metadata.c_str(), "wt");
+	if (m_json == NULL) {
+		LogError("Cannot open the metadata file - %s, errno=%d", m_metadata.c_str(), errno);
+		::fclose(m_in);
+		return 1;
+	}
+
+	m_wav = new CWAVFileWriter(m_audio, SOUNDCARD_SAMPLE_RATE);
+	if (!m_wav->open()) {
+		delete m_wav;
+		::fclose(m_json);
+		::fclose(m_in);
+		return 1;
+	}
+
+	if (!m_rssi.empty())
+		m_rssiMapper.load(m_rssi);
+
+	::fprintf(m_json, "{\n\t\"capture\": \"%s\",\n\t\"events\": [", escape(m_input).c_str());
+
+	CM17RX rx(std::string(), &m_rssiMapper, false);
+	rx.setStatusCallback(this);
+
+	unsigned long long elapsed = 0ULL;
+	bool ok = true;
+
+	unsigned char data[MAX_FRAME_LENGTH];
+	unsigned int len = 0U;
+
+	uint8_t soft[M17_FRAME_LENGTH_BITS];
+
+	// No pacing, each frame is decoded as soon as it is read
+	while (ok && (m_soft ? readSoft(data[0U], soft) : (m_trace ? readTrace(data, len) : readBinary(data, len)))) {
+		unsigned long long start = nowNS();
+		if (m_soft)
+			rx.writeSoft(data[0U], soft);
+		else
+			rx.write(data, len);
+		elapsed += nowNS() - start;
+
+		float audio[SOUNDCARD_BLOCK_SIZE];
+		for (;;) {
+			start = nowNS();
+			unsigned int n = rx.read(audio, SOUNDCARD_BLOCK_SIZE);
+			elapsed += nowNS() - start;
+
+			if (n == 0U)
+				break;
+
+			if (!m_wav->write(audio, n)) {
+				ok = false;
+				break;
+			}
+		}
+
+		// Only the stream frames carry audio
+		if (data[0U] == TAG_DATA)
+			m_frames++;
+	}
+
+	double seconds = double(elapsed) / 1000000000.0;
+	double audio   = double(m_frames) * 0.04;
+
+	::fprintf(m_json, "%s],\n", m_events > 0U ? "\n\t" : "");
+	::fprintf(m_json, "\t\"frames\": %u,\n", m_frames);
+	::fprintf(m_json, "\t\"samples\": %u,\n", m_wav->getSamples());
+	::fprintf(m_json, "\t\"sample_rate\": %u,\n", SOUNDCARD_SAMPLE_RATE);
+	::fprintf(m_json, "\t\"decode_seconds\": %.6f,\n", seconds);
+	::fprintf(m_json, "\t\"frames_per_second\": %.1f\n", seconds > 0.0 ? double(m_frames) / seconds : 0.0);
+	::fprintf(m_json, "}\n");
+
+	m_wav->close();
+	delete m_wav;
+	m_wav = NULL;
+
+	::fclose(m_json);
+	::fclose(m_in);
+
+	if (seconds > 0.0)
+		LogMessage("Decoded %u frames in %.3fs, %.0f frames/s, %.1fx real time", m_frames, seconds, double(m_frames) / seconds, audio / seconds);
+	else
+		LogMessage("Decoded %u frames", m_frames);
+
+	return ok ? 0 : 1;
+}
+
+bool CM17Decode::readBinary(unsigned char* data, unsigned int& len)
+{
+	assert(data != NULL);
+
+	// The same records as the modem RX queue, a length byte then the tag and payload
+	for (;;) {
+		int c = ::fgetc(m_in);
+		if (c == EOF)
+			return false;
+
+		len = (unsigned int)c;
+		if (len == 0U)
+			continue;
+
+		if (::fread(data, 1U, len, m_in) != len) {
+			LogWarning("Truncated frame at the end of %s", m_input.c_str());
+			return false;
+		}
+
+		// Only the tag on its own, or the tag, a zero and a whole frame,
+		// optionally followed by the RSSI
+		if (len != 1U && len != (M17_FRAME_LENGTH_BYTES + 2U) && len != (M17_FRAME_LENGTH_BYTES + 4U)) {
+			LogWarning("Skipping a record of %u bytes in %s", len, m_input.c_str());
+			continue;
+		}
+
+		return true;
+	}
+}
+
+bool CM17Decode::readSoft(unsigned char& type, uint8_t* soft)
+{
+	assert(soft != NULL);
+
+	// The tag then one byte a bit for the whole frame, from 0x00 for a
+	// certain 0 to 0xFF for a certain 1, as written by M17Encode --soft
+	int c = ::fgetc(m_in);
+	if (c == EOF)
+		return false;
+
+	type = (unsigned char)c;
+
+	if (::fread(soft, 1U, M17_FRAME_LENGTH_BITS, m_in) != M17_FRAME_LENGTH_BITS) {
+		LogWarning("Truncated frame at the end of %s", m_input.c_str());
+		return false;
+	}
+
+	return true;
+}
+
+bool CM17Decode::readTrace(unsigned char* data, unsigned int& len)
+{
+	assert(data != NULL);
+
+	// The output of CUtils::dump() for the modem's RX M17 frames, a title
+	// line followed by sixteen bytes a line of the raw MMDVM frame
+	char line[300U];
+	while (::fgets(line, 300, m_in) != NULL) {
+		unsigned char tag;
+		if (::strstr(line, "RX M17 Link Setup") != NULL)
+			tag = TAG_HEADER;
+		else if (::strstr(line, "RX M17 Stream Data") != NULL)
+			tag = TAG_DATA;
+		else if (::strstr(line, "RX M17 EOT") != NULL)
+			tag = TAG_EOT;
+		else if (::strstr(line, "RX M17 Lost") != NULL)
+			tag = TAG_LOST;
+		else
+			continue;
+
+		unsigned char buffer[MAX_FRAME_LENGTH];
+		unsigned int length = 3U;
+		unsigned int n = 0U;
+
+		while (n < length && ::fgets(line, 300, m_in) != NULL) {
+			char* p = ::strstr(line, ":  ");
+			if (p == NULL)
+				break;
+
+			for (p += 3; n < length && ::isxdigit(p[0U]) && ::isxdigit(p[1U]) && p[2U] == ' '; p += 3) {
+				buffer[n++] = (unsigned char)::strtoul(std::string(p, 2U).c_str(), NULL, 16);
+				if (n == 2U)
+					length = buffer[1U];
+			}
+		}
+
+		if (n < 3U || n < length || buffer[0U] != MMDVM_FRAME_START) {
+			LogWarning("Skipping an incomplete M17 frame in %s", m_input.c_str());
+			continue;
+		}
+
+		data[0U] = tag;
+
+		if (tag == TAG_HEADER || tag == TAG_DATA) {
+			::memcpy(data + 1U, buffer + 3U, length - 3U);
+			len = length - 2U;
+		} else {
+			len = 1U;
+		}
+
+		return true;
+	}
+
+	return false;
+}
+
+void CM17Decode::statusCallback(const std::string& source, const std::string& dest, bool end)
+{
+	std::string fields = ", \"source\": \"" + escape(source) + "\", \"destination\": \"" + escape(dest) + "\"";
+
+	writeEvent(end ? "end" : "start", fields);
+}
+
+void CM17Decode::textCallback(const char* text)
+{
+	assert(text != NULL);
+
+	writeEvent("text", ", \"text\": \"" + escape(text) + "\"");
+}
+
+void CM17Decode::rssiCallback(int rssi)
+{
+	char buffer[50U];
+	::sprintf(buffer, ", \"rssi\": %d", rssi);
+
+	writeEvent("rssi", buffer);
+}
+
+void CM17Decode::gpsCallback(float latitude, float longitude, const std::string& locator,
+		const std::optional<float>& altitude,
+		const std::optional<float>& speed, const std::optional<float>& track,
+		const std::optional<float>& bearing, const std::optional<float>& distance)
+{
+	char buffer[100U];
+	::sprintf(buffer, ", \"latitude\": %f, \"longitude\": %f", latitude, longitude);
+
+	std::string fields = buffer;
+	fields += ", \"locator\": \"" + escape(locator) + "\"";
+
+	if (altitude) {
+		::sprintf(buffer, ", \"altitude\": %f", altitude.value());
+		fields += buffer;
+	}
+
+	if (speed) {
+		::sprintf(buffer, ", \"speed\": %f", speed.value());
+		fields += buffer;
+	}
+
+	if (track) {
+		::sprintf(buffer, ", \"track\": %f", track.value());
+		fields += buffer;
+	}
+
+	if (bearing) {
+		::sprintf(buffer, ", \"bearing\": %f", bearing.value());
+		fields += buffer;
+	}
+
+	if (distance) {
+		::sprintf(buffer, ", \"distance\": %f", distance.value());
+		fields += buffer;
+	}
+
+	writeEvent("gps", fields);
+}
+
+void CM17Decode::callsignsCallback(const char* callsigns)
+{
+	assert(callsigns != NULL);
+
+	writeEvent("callsigns", ", \"callsigns\": \"" + escape(callsigns) + "\"");
+}
+
+void CM17Decode::writeEvent(const char* type, const std::string& fields)
+{
+	assert(type != NULL);
+	assert(m_json != NULL);
+	assert(m_wav != NULL);
+
+	// The time is the position in the audio file
+	double time = double(m_wav->getSamples()) / double(SOUNDCARD_SAMPLE_RATE);
+
+	::fprintf(m_json, "%s\n\t\t{ \"frame\": %u, \"time\": %.3f, \"type\": \"%s\"%s }", m_events > 0U ? "," : "", m_frames, time, type, fields.c_str());
+
+	m_events++;
+}
+
+std::string CM17Decode::escape(const std::string& text) const
+{
+	std::string out;
+
+	for (std::string::const_iterator it = text.cbegin(); it != text.cend(); ++it) {
+		unsigned char c = *it;
+
+		if (c == '"' || c == '\\') {
+			out += '\\';
+			out += c;
+		} else if (c < 0x20U || c >= 0x7FU) {
+			char buffer[10U];
+			::sprintf(buffer, "\\u%04X", c);
+			out += buffer;
+		} else {
+			out += c;
+		}
+	}
+
+	return out;
+}
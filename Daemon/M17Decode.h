@@ -0,0 +1,76 @@
+/*
+ *   Copyright (C) 2022 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#if !defined(M17DECODE_H)
+#define	M17DECODE_H
+
+#include "RSSIInterpolator.h"
+#include "StatusCallback.h"
+#include "WAVFileWriter.h"
+#include "M17RX.h"
+
+#include <string>
+
+#include <cstdio>
+
+class CM17Decode : public IStatusCallback {
+public:
+	CM17Decode(const std::string& input, const std::string& audio, const std::string& metadata, bool trace, bool soft, const std::string& rssi);
+	virtual ~CM17Decode();
+
+	int run();
+
+	virtual void statusCallback(const std::string& source, const std::string& dest, bool end);
+
+	virtual void textCallback(const char* text);
+
+	virtual void rssiCallback(int rssi);
+
+	virtual void gpsCallback(float latitude, float longitude, const std::string& locator,
+			const std::optional<float>& altitude,
+			const std::optional<float>& speed, const std::optional<float>& track,
+			const std::optional<float>& bearing, const std::optional<float>& distance);
+
+	virtual void callsignsCallback(const char* callsigns);
+
+private:
+	std::string       m_input;
+	std::string       m_audio;
+	std::string       m_metadata;
+	bool              m_trace;
+	bool              m_soft;
+	std::string       m_rssi;
+	FILE*             m_in;
+	FILE*             m_json;
+	CWAVFileWriter*   m_wav;
+	CRSSIInterpolator m_rssiMapper;
+	unsigned int      m_frames;
+	unsigned int      m_events;
+
+	bool readBinary(unsigned char* data, unsigned int& len);
+	bool readTrace(unsigned char* data, unsigned int& len);
+	bool readSoft(unsigned char& type, uint8_t* soft);
+
+	bool drain(CM17RX& rx);
+
+	void writeEvent(const char* type, const std::string& fields);
+
+	std::string escape(const std::string& text) const;
+};
+
+#endif
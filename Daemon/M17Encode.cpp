@@ -0,0 +1,325 @@
+/*
+ *   Copyright (C) 2022 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include "M17Encode.h"
+#include "WAVFileReader.h"
+#include "M17Defines.h"
+#include "GitVersion.h"
+#include "Defines.h"
+#include "Version.h"
+#include "Log.h"
+
+#include <samplerate.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cassert>
+#include <cerrno>
+#include <ctime>
+
+const unsigned int MAX_FRAME_LENGTH = 255U;
+
+const unsigned char BIT_MASK_TABLE[] = {0x80U, 0x40U, 0x20U, 0x10U, 0x08U, 0x04U, 0x02U, 0x01U};
+
+#define READ_BIT(p,i)    (p[(i)>>3] & BIT_MASK_TABLE[(i)&7])
+
+static unsigned long long nowNS()
+{
+	struct timespec now;
+	::clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+int main(int argc, char** argv)
+{
+	std::string source;
+	std::string dest = "ALL";
+	std::string text;
+	std::string gpsType = "Fixed";
+	std::string position;
+	unsigned int can = 0U;
+	unsigned int mode = 3200U;
+	unsigned int micGain = 100U;
+	bool soft = false;
+	bool debug = false;
+	std::vector<std::string> files;
+
+	for (int currentArg = 1; currentArg < argc; ++currentArg) {
+		std::string arg = argv[currentArg];
+		bool hasValue = (currentArg + 1) < argc;
+
+		if ((arg == "-v") || (arg == "--version")) {
+			::fprintf(stdout, "M17Encode version %s git #%.7s\n", VERSION, gitversion);
+			return 0;
+		} else if (((arg == "-s") || (arg == "--source")) && hasValue) {
+			source = argv[++currentArg];
+		} else if (((arg == "-d") || (arg == "--dest")) && hasValue) {
+			dest = argv[++currentArg];
+		} else if (((arg == "-c") || (arg == "--can")) && hasValue) {
+			can = (unsigned int)::atoi(argv[++currentArg]);
+		} else if (((arg == "-m") || (arg == "--mode")) && hasValue) {
+			mode = (unsigned int)::atoi(argv[++currentArg]);
+		} else if (((arg == "-t") || (arg == "--text")) && hasValue) {
+			text = argv[++currentArg];
+		} else if (((arg == "-p") || (arg == "--position")) && hasValue) {
+			position = argv[++currentArg];
+		} else if ((arg == "--gps-type") && hasValue) {
+			gpsType = argv[++currentArg];
+		} else if ((arg == "--mic-gain") && hasValue) {
+			micGain = (unsigned int)::atoi(argv[++currentArg]);
+		} else if ((arg == "-S") || (arg == "--soft")) {
+			soft = true;
+		} else if ((arg == "-D") || (arg == "--debug")) {
+			debug = true;
+		} else if (arg.substr(0,1) == "-") {
+			files.clear();
+			break;
+		} else {
+			files.push_back(arg);
+		}
+	}
+
+	if (files.size() != 2U || source.empty() || (mode != 3200U && mode != 1600U) || can > 15U) {
+		::fprintf(stderr, "Usage: M17Encode [-v|--version] -s|--source <callsign> [-d|--dest <callsign>] [-c|--can <0-15>] [-m|--mode <3200|1600>]\n");
+		::fprintf(stderr, "                 [-t|--text <text>] [-p|--position <lat,lon[,alt]>] [--gps-type <Fixed|Mobile|Handheld>]\n");
+		::fprintf(stderr, "                 [--mic-gain <percent>] [-S|--soft] [-D|--debug] <audio.wav> <frames.bin>\n");
+		return 1;
+	}
+
+	// Log to the display only
+	::LogInitialise(false, "", "", 0U, debug ? 1U : 2U, false);
+
+	CM17Encode* encode = new CM17Encode(files.at(0U), files.at(1U), source, dest, can, mode, text, micGain, soft);
+
+	if (!position.empty()) {
+		char* p1 = ::strtok(&position[0U], ",");
+		char* p2 = ::strtok(NULL, ",");
+		char* p3 = ::strtok(NULL, ",");
+
+		if (p1 == NULL || p2 == NULL) {
+			::fprintf(stderr, "M17Encode: the position must be <lat,lon[,alt]>\n");
+			delete encode;
+			return 1;
+		}
+
+		std::optional<float> altitude;
+		if (p3 != NULL)
+			altitude = float(::atof(p3));
+
+		encode->setGPS(float(::atof(p1)), float(::atof(p2)), altitude, gpsType);
+	}
+
+	int ret = encode->run();
+
+	delete encode;
+
+	::LogFinalise();
+
+	return ret;
+}
+
+CM17Encode::CM17Encode(const std::string& input, const std::string& output, const std::string& source, const std::string& dest,
+		unsigned int can, unsigned int mode, const std::string& text, unsigned int micGain, bool soft) :
+m_input(input),
+m_output(output),
+m_source(source),
+m_dest(dest),
+m_can(can),
+m_mode(mode),
+m_text(text),
+m_micGain(micGain),
+m_soft(soft),
+m_gps(false),
+m_latitude(0.0F),
+m_longitude(0.0F),
+m_altitude(),
+m_gpsType(),
+m_out(NULL),
+m_frames(0U)
+{
+}
+
+CM17Encode::~CM17Encode()
+{
+}
+
+void CM17Encode::setGPS(float latitude, float longitude, const std::optional<float>& altitude, const std::string& type)
+{
+	m_gps       = true;
+	m_latitude  = latitude;
+	m_longitude = longitude;
+	m_altitude  = altitude;
+	m_gpsType   = type;
+}
+
+int CM17Encode::run()
+{
+	std::vector<float> audio;
+	unsigned int sampleRate;
+	if (!readAudio(audio, sampleRate))
+		return 1;
+
+	if (audio.empty()) {
+		LogError("No audio in %s", m_input.c_str());
+		return 1;
+	}
+
+	m_out = ::fopen(m_output.c_str(), "wb");
+	if (m_out == NULL) {
+		LogError("Cannot open the frames file - %s, errno=%d", m_output.c_str(), errno);
+		return 1;
+	}
+
+	// Codec rate audio goes straight to the encoder
+	unsigned int blockSize = sampleRate == CODEC_SAMPLE_RATE ? CODEC_BLOCK_SIZE : SOUNDCARD_BLOCK_SIZE;
+
+	// Pad to a whole number of frames, plus one block to carry the EOT
+	unsigned int blocks = (audio.size() + blockSize - 1U) / blockSize;
+	audio.resize((blocks + 1U) * blockSize, 0.0F);
+
+	CM17TX tx(m_source, m_text, m_micGain);
+	if (sampleRate == CODEC_SAMPLE_RATE)
+		tx.setResampler(RT_NONE);
+	tx.setParams(m_can, m_mode);
+	tx.setDestination(m_dest);
+	tx.start();
+
+	if (m_gps) {
+		std::optional<float> speed;
+		std::optional<float> track;
+		tx.setGPS(m_latitude, m_longitude, m_altitude, speed, track, m_gpsType);
+	}
+
+	unsigned long long elapsed = 0ULL;
+	bool ok = true;
+
+	// No pacing, each block is encoded as soon as it is written
+	for (unsigned int i = 0U; ok && i <= blocks; i++) {
+		unsigned long long start = nowNS();
+
+		if (i == blocks)
+			tx.end();
+
+		tx.write(audio.data() + i * blockSize, blockSize);
+		tx.process();
+
+		elapsed += nowNS() - start;
+
+		ok = drain(tx, elapsed);
+	}
+
+	::fclose(m_out);
+	m_out = NULL;
+
+	double seconds = double(elapsed) / 1000000000.0;
+
+	if (seconds > 0.0)
+		LogMessage("Encoded %u frames in %.3fs, %.0f frames/s, %.1fx real time", m_frames, seconds, double(m_frames) / seconds, (double(blocks) * 0.04) / seconds);
+	else
+		LogMessage("Encoded %u frames", m_frames);
+
+	return ok ? 0 : 1;
+}
+
+bool CM17Encode::readAudio(std::vector<float>& audio, unsigned int& sampleRate)
+{
+	CWAVFileReader reader(m_input);
+	if (!reader.open())
+		return false;
+
+	float buffer[4096U];
+	unsigned int n;
+	while ((n = reader.read(buffer, 4096U)) > 0U)
+		audio.insert(audio.end(), buffer, buffer + n);
+
+	sampleRate = reader.getSampleRate();
+
+	reader.close();
+
+	if (sampleRate == SOUNDCARD_SAMPLE_RATE || sampleRate == CODEC_SAMPLE_RATE || audio.empty())
+		return true;
+
+	// CM17TX takes soundcard or codec rate audio, so anything else is converted first
+	LogMessage("Converting %s from %u Hz to %u Hz", m_input.c_str(), sampleRate, SOUNDCARD_SAMPLE_RATE);
+
+	double ratio = double(SOUNDCARD_SAMPLE_RATE) / double(sampleRate);
+
+	std::vector<float> output((unsigned int)(double(audio.size()) * ratio) + 1U);
+
+	SRC_DATA data;
+	data.data_in       = audio.data();
+	data.data_out      = output.data();
+	data.input_frames  = audio.size();
+	data.output_frames = output.size();
+	data.end_of_input  = 1;
+	data.src_ratio     = ratio;
+
+	int ret = ::src_simple(&data, SRC_SINC_MEDIUM_QUALITY, 1);
+	if (ret != 0) {
+		LogError("Error from the resampler - %d - %s", ret, ::src_strerror(ret));
+		return false;
+	}
+
+	output.resize(data.output_frames_gen);
+	audio.swap(output);
+
+	sampleRate = SOUNDCARD_SAMPLE_RATE;
+
+	return true;
+}
+
+bool CM17Encode::drain(CM17TX& tx, unsigned long long& elapsed)
+{
+	assert(m_out != NULL);
+
+	// The same records as CM17Decode reads, a length byte then the tag and
+	// frame, or with --soft the tag then one byte a bit set to 0x00 or 0xFF
+	for (;;) {
+		unsigned char data[MAX_FRAME_LENGTH];
+
+		unsigned long long start = nowNS();
+		unsigned int len = tx.read(data);
+		elapsed += nowNS() - start;
+
+		if (len == 0U)
+			return true;
+
+		bool ok;
+		if (m_soft) {
+			const unsigned char* frame = data + 2U;
+
+			uint8_t soft[M17_FRAME_LENGTH_BITS];
+			for (unsigned int i = 0U; i < M17_FRAME_LENGTH_BITS; i++)
+				soft[i] = READ_BIT(frame, i) ? 0xFFU : 0x00U;
+
+			ok = ::fwrite(data, 1U, 1U, m_out) == 1U && ::fwrite(soft, 1U, M17_FRAME_LENGTH_BITS, m_out) == M17_FRAME_LENGTH_BITS;
+		} else {
+			unsigned char length = len;
+			ok = ::fwrite(&length, 1U, 1U, m_out) == 1U && ::fwrite(data, 1U, len, m_out) == len;
+		}
+
+		if (!ok) {
+			LogError("Error writing to the frames file - %s, errno=%d", m_output.c_str(), errno);
+			return false;
+		}
+
+		m_frames++;
+	}
+}
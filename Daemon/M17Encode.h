@@ -0,0 +1,63 @@
+/*
+ *   Copyright (C) 2022 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#if !defined(M17ENCODE_H)
+#define	M17ENCODE_H
+
+#include "M17TX.h"
+
+#include <string>
+#include <vector>
+#include <optional>
+
+#include <cstdio>
+
+class CM17Encode {
+public:
+	CM17Encode(const std::string& input, const std::string& output, const std::string& source, const std::string& dest,
+			unsigned int can, unsigned int mode, const std::string& text, unsigned int micGain, bool soft);
+	~CM17Encode();
+
+	void setGPS(float latitude, float longitude, const std::optional<float>& altitude, const std::string& type);
+
+	int run();
+
+private:
+	std::string          m_input;
+	std::string          m_output;
+	std::string          m_source;
+	std::string          m_dest;
+	unsigned int         m_can;
+	unsigned int         m_mode;
+	std::string          m_text;
+	unsigned int         m_micGain;
+	bool                 m_soft;
+	bool                 m_gps;
+	float                m_latitude;
+	float                m_longitude;
+	std::optional<float> m_altitude;
+	std::string          m_gpsType;
+	FILE*                m_out;
+	unsigned int         m_frames;
+
+	bool readAudio(std::vector<float>& audio, unsigned int& sampleRate);
+
+	bool drain(CM17TX& tx, unsigned long long& elapsed);
+};
+
+#endif
@@ -0,0 +1,37 @@
+/*
+ *   Copyright (C) 2022 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#if !defined(M17Framing_H)
+#define  M17Framing_H
+
+#include <cstdint>
+
+// The interleaving and scrambling applied to everything after the sync word
+// of an M17 frame. The interleaver is its own inverse and the scrambler is
+// an XOR so the same functions are used for both RX and TX. The soft versions
+// take one bit per byte.
+class CM17Framing {
+public:
+	static void interleave(const unsigned char* in, unsigned char* out);
+	static void decorrelate(const unsigned char* in, unsigned char* out);
+
+	static void interleaveSoft(const uint8_t* in, uint8_t* out);
+	static void decorrelateSoft(const uint8_t* in, uint8_t* out);
+};
+
+#endif
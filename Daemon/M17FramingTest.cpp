@@ -0,0 +1,141 @@
+/*
+ *   Copyright (C) 2022 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include "M17Framing.h"
+#include "M17Defines.h"
+#include "TestUtils.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+const unsigned int RUNS = 100000U;
+
+// The tables and the per bit code that were in M17RX.cpp and M17TX.cpp
+// before CM17Framing, kept here as the reference
+const unsigned int INTERLEAVER[] = {
+	0U, 137U, 90U, 227U, 180U, 317U, 270U, 39U, 360U, 129U, 82U, 219U, 172U, 309U, 262U, 31U, 352U, 121U, 74U, 211U, 164U,
+	301U, 254U, 23U, 344U, 113U, 66U, 203U, 156U, 293U, 246U, 15U, 336U, 105U, 58U, 195U, 148U, 285U, 238U, 7U, 328U, 97U,
+	50U, 187U, 140U, 277U, 230U, 367U, 320U, 89U, 42U, 179U, 132U, 269U, 222U, 359U, 312U, 81U, 34U, 171U, 124U, 261U, 214U,
+	351U, 304U, 73U, 26U, 163U, 116U, 253U, 206U, 343U, 296U, 65U, 18U, 155U, 108U, 245U, 198U, 335U, 288U, 57U, 10U, 147U,
+	100U, 237U, 190U, 327U, 280U, 49U, 2U, 139U, 92U, 229U, 182U, 319U, 272U, 41U, 362U, 131U, 84U, 221U, 174U, 311U, 264U,
+	33U, 354U, 123U, 76U, 213U, 166U, 303U, 256U, 25U, 346U, 115U, 68U, 205U, 158U, 295U, 248U, 17U, 338U, 107U, 60U, 197U,
+	150U, 287U, 240U, 9U, 330U, 99U, 52U, 189U, 142U, 279U, 232U, 1U, 322U, 91U, 44U, 181U, 134U, 271U, 224U, 361U, 314U, 83U,
+	36U, 173U, 126U, 263U, 216U, 353U, 306U, 75U, 28U, 165U, 118U, 255U, 208U, 345U, 298U, 67U, 20U, 157U, 110U, 247U, 200U,
+	337U, 290U, 59U, 12U, 149U, 102U, 239U, 192U, 329U, 282U, 51U, 4U, 141U, 94U, 231U, 184U, 321U, 274U, 43U, 364U, 133U, 86U,
+	223U, 176U, 313U, 266U, 35U, 356U, 125U, 78U, 215U, 168U, 305U, 258U, 27U, 348U, 117U, 70U, 207U, 160U, 297U, 250U, 19U,
+	340U, 109U, 62U, 199U, 152U, 289U, 242U, 11U, 332U, 101U, 54U, 191U, 144U, 281U, 234U, 3U, 324U, 93U, 46U, 183U, 136U, 273U,
+	226U, 363U, 316U, 85U, 38U, 175U, 128U, 265U, 218U, 355U, 308U, 77U, 30U, 167U, 120U, 257U, 210U, 347U, 300U, 69U, 22U,
+	159U, 112U, 249U, 202U, 339U, 292U, 61U, 14U, 151U, 104U, 241U, 194U, 331U, 284U, 53U, 6U, 143U, 96U, 233U, 186U, 323U,
+	276U, 45U, 366U, 135U, 88U, 225U, 178U, 315U, 268U, 37U, 358U, 127U, 80U, 217U, 170U, 307U, 260U, 29U, 350U, 119U, 72U,
+	209U, 162U, 299U, 252U, 21U, 342U, 111U, 64U, 201U, 154U, 291U, 244U, 13U, 334U, 103U, 56U, 193U, 146U, 283U, 236U, 5U,
+	326U, 95U, 48U, 185U, 138U, 275U, 228U, 365U, 318U, 87U, 40U, 177U, 130U, 267U, 220U, 357U, 310U, 79U, 32U, 169U, 122U,
+	259U, 212U, 349U, 302U, 71U, 24U, 161U, 114U, 251U, 204U, 341U, 294U, 63U, 16U, 153U, 106U, 243U, 196U, 333U, 286U, 55U,
+	8U, 145U, 98U, 235U, 188U, 325U, 278U, 47U};
+
+const unsigned char SCRAMBLER[] = {
+	0x00U, 0x00U, 0xD6U, 0xB5U, 0xE2U, 0x30U, 0x82U, 0xFFU, 0x84U, 0x62U, 0xBAU, 0x4EU, 0x96U, 0x90U, 0xD8U, 0x98U, 0xDDU,
+	0x5DU, 0x0CU, 0xC8U, 0x52U, 0x43U, 0x91U, 0x1DU, 0xF8U, 0x6EU, 0x68U, 0x2FU, 0x35U, 0xDAU, 0x14U, 0xEAU, 0xCDU, 0x76U,
+	0x19U, 0x8DU, 0xD5U, 0x80U, 0xD1U, 0x33U, 0x87U, 0x13U, 0x57U, 0x18U, 0x2DU, 0x29U, 0x78U, 0xC3U};
+
+const unsigned char BIT_MASK_TABLE[] = {0x80U, 0x40U, 0x20U, 0x10U, 0x08U, 0x04U, 0x02U, 0x01U};
+
+#define WRITE_BIT(p,i,b) p[(i)>>3] = (b) ? (p[(i)>>3] | BIT_MASK_TABLE[(i)&7]) : (p[(i)>>3] & ~BIT_MASK_TABLE[(i)&7])
+#define READ_BIT(p,i)    (p[(i)>>3] & BIT_MASK_TABLE[(i)&7])
+
+static void interleaver(const unsigned char* in, unsigned char* out)
+{
+	for (unsigned int i = 0U; i < (M17_FRAME_LENGTH_BITS - M17_SYNC_LENGTH_BITS); i++) {
+		unsigned int n1 = i + M17_SYNC_LENGTH_BITS;
+		bool b = READ_BIT(in, n1) != 0U;
+		unsigned int n2 = INTERLEAVER[i] + M17_SYNC_LENGTH_BITS;
+		WRITE_BIT(out, n2, b);
+	}
+}
+
+static void decorrelator(const unsigned char* in, unsigned char* out)
+{
+	for (unsigned int i = M17_SYNC_LENGTH_BYTES; i < M17_FRAME_LENGTH_BYTES; i++)
+		out[i] = in[i] ^ SCRAMBLER[i];
+}
+
+static void interleaverSoft(const uint8_t* in, uint8_t* out)
+{
+	for (unsigned int i = 0U; i < (M17_FRAME_LENGTH_BITS - M17_SYNC_LENGTH_BITS); i++)
+		out[INTERLEAVER[i] + M17_SYNC_LENGTH_BITS] = in[i + M17_SYNC_LENGTH_BITS];
+}
+
+static void decorrelatorSoft(const uint8_t* in, uint8_t* out)
+{
+	for (unsigned int i = M17_SYNC_LENGTH_BITS; i < M17_FRAME_LENGTH_BITS; i++)
+		out[i] = READ_BIT(SCRAMBLER, i) != 0U ? in[i] ^ 0xFFU : in[i];
+}
+
+int main(int argc, char** argv)
+{
+	CTestUtils::seed(argc, argv);
+
+	unsigned int failures[4U] = {0U, 0U, 0U, 0U};
+
+	for (unsigned int n = 0U; n < RUNS; n++) {
+		unsigned char in[M17_FRAME_LENGTH_BYTES];
+		CTestUtils::randomBytes(in, M17_FRAME_LENGTH_BYTES);
+
+		// Only the bits after the sync word are written
+		unsigned char out1[M17_FRAME_LENGTH_BYTES];
+		unsigned char out2[M17_FRAME_LENGTH_BYTES];
+		::memset(out1, 0x00U, M17_FRAME_LENGTH_BYTES);
+		::memset(out2, 0x00U, M17_FRAME_LENGTH_BYTES);
+
+		interleaver(in, out1);
+		CM17Framing::interleave(in, out2);
+		if (::memcmp(out1, out2, M17_FRAME_LENGTH_BYTES) != 0)
+			failures[0U]++;
+
+		decorrelator(in, out1);
+		CM17Framing::decorrelate(in, out2);
+		if (::memcmp(out1, out2, M17_FRAME_LENGTH_BYTES) != 0)
+			failures[1U]++;
+
+		uint8_t soft[M17_FRAME_LENGTH_BITS];
+		CTestUtils::randomBytes(soft, M17_FRAME_LENGTH_BITS);
+
+		uint8_t softOut1[M17_FRAME_LENGTH_BITS];
+		uint8_t softOut2[M17_FRAME_LENGTH_BITS];
+		::memset(softOut1, 0x00U, M17_FRAME_LENGTH_BITS);
+		::memset(softOut2, 0x00U, M17_FRAME_LENGTH_BITS);
+
+		interleaverSoft(soft, softOut1);
+		CM17Framing::interleaveSoft(soft, softOut2);
+		if (::memcmp(softOut1, softOut2, M17_FRAME_LENGTH_BITS) != 0)
+			failures[2U]++;
+
+		decorrelatorSoft(soft, softOut1);
+		CM17Framing::decorrelateSoft(soft, softOut2);
+		if (::memcmp(softOut1, softOut2, M17_FRAME_LENGTH_BITS) != 0)
+			failures[3U]++;
+	}
+
+	bool ok = true;
+	ok &= CTestUtils::report("interleave", RUNS, failures[0U]);
+	ok &= CTestUtils::report("decorrelate", RUNS, failures[1U]);
+	ok &= CTestUtils::report("interleaveSoft", RUNS, failures[2U]);
+	ok &= CTestUtils::report("decorrelateSoft", RUNS, failures[3U]);
+
+	return ok ? 0 : 1;
+}
@@ -13,6 +13,7 @@
 
 #include "M17RX.h"
 #include "M17Convolution.h"
+#include "M17Framing.h"
 #include "Golay24128.h"
 #include "M17Utils.h"
 #include "M17CRC.h"
@@ -33,43 +34,33 @@ const float END_MARK = 2000.0F;
 
 const unsigned int  SILENCE_BLOCK_COUNT = 5U;
 
+// The adaptive jitter buffer, the depth is smoothed over about eight frames
+// and left alone within the hysteresis either side of the target
+const float         JITTER_SMOOTHING     = 0.125F;
+const float         JITTER_HYSTERESIS_MS = 40.0F;
+const float         JITTER_LOW_MS        = 40.0F;
+
+// Packet loss concealment, a lost or corrupted frame repeats the last
+// decoded model, fading by the factor for each further codec frame, and
+// is muted after the maximum. Gaps in the frame number longer than the
+// maximum gap are taken as a corrupted frame number and not filled
+const unsigned int  PLC_MAX_FRAMES = 3U;
+const float         PLC_FADE       = 0.7F;
+const unsigned int  PLC_MAX_GAP    = 25U;
+const unsigned int  PLC_FRAME_MS   = 40U;
+
 const unsigned int  BLEEP_FREQ   = 2000U;
 const unsigned int  BLEEP_LENGTH = 100U;
 const float         BLEEP_AMPL   = 0.1F;
 
-const unsigned int INTERLEAVER[] = {
-	0U, 137U, 90U, 227U, 180U, 317U, 270U, 39U, 360U, 129U, 82U, 219U, 172U, 309U, 262U, 31U, 352U, 121U, 74U, 211U, 164U,
-	301U, 254U, 23U, 344U, 113U, 66U, 203U, 156U, 293U, 246U, 15U, 336U, 105U, 58U, 195U, 148U, 285U, 238U, 7U, 328U, 97U,
-	50U, 187U, 140U, 277U, 230U, 367U, 320U, 89U, 42U, 179U, 132U, 269U, 222U, 359U, 312U, 81U, 34U, 171U, 124U, 261U, 214U,
-	351U, 304U, 73U, 26U, 163U, 116U, 253U, 206U, 343U, 296U, 65U, 18U, 155U, 108U, 245U, 198U, 335U, 288U, 57U, 10U, 147U,
-	100U, 237U, 190U, 327U, 280U, 49U, 2U, 139U, 92U, 229U, 182U, 319U, 272U, 41U, 362U, 131U, 84U, 221U, 174U, 311U, 264U,
-	33U, 354U, 123U, 76U, 213U, 166U, 303U, 256U, 25U, 346U, 115U, 68U, 205U, 158U, 295U, 248U, 17U, 338U, 107U, 60U, 197U,
-	150U, 287U, 240U, 9U, 330U, 99U, 52U, 189U, 142U, 279U, 232U, 1U, 322U, 91U, 44U, 181U, 134U, 271U, 224U, 361U, 314U, 83U,
-	36U, 173U, 126U, 263U, 216U, 353U, 306U, 75U, 28U, 165U, 118U, 255U, 208U, 345U, 298U, 67U, 20U, 157U, 110U, 247U, 200U,
-	337U, 290U, 59U, 12U, 149U, 102U, 239U, 192U, 329U, 282U, 51U, 4U, 141U, 94U, 231U, 184U, 321U, 274U, 43U, 364U, 133U, 86U,
-	223U, 176U, 313U, 266U, 35U, 356U, 125U, 78U, 215U, 168U, 305U, 258U, 27U, 348U, 117U, 70U, 207U, 160U, 297U, 250U, 19U,
-	340U, 109U, 62U, 199U, 152U, 289U, 242U, 11U, 332U, 101U, 54U, 191U, 144U, 281U, 234U, 3U, 324U, 93U, 46U, 183U, 136U, 273U,
-	226U, 363U, 316U, 85U, 38U, 175U, 128U, 265U, 218U, 355U, 308U, 77U, 30U, 167U, 120U, 257U, 210U, 347U, 300U, 69U, 22U,
-	159U, 112U, 249U, 202U, 339U, 292U, 61U, 14U, 151U, 104U, 241U, 194U, 331U, 284U, 53U, 6U, 143U, 96U, 233U, 186U, 323U,
-	276U, 45U, 366U, 135U, 88U, 225U, 178U, 315U, 268U, 37U, 358U, 127U, 80U, 217U, 170U, 307U, 260U, 29U, 350U, 119U, 72U,
-	209U, 162U, 299U, 252U, 21U, 342U, 111U, 64U, 201U, 154U, 291U, 244U, 13U, 334U, 103U, 56U, 193U, 146U, 283U, 236U, 5U,
-	326U, 95U, 48U, 185U, 138U, 275U, 228U, 365U, 318U, 87U, 40U, 177U, 130U, 267U, 220U, 357U, 310U, 79U, 32U, 169U, 122U,
-	259U, 212U, 349U, 302U, 71U, 24U, 161U, 114U, 251U, 204U, 341U, 294U, 63U, 16U, 153U, 106U, 243U, 196U, 333U, 286U, 55U,
-	8U, 145U, 98U, 235U, 188U, 325U, 278U, 47U};
-
-const unsigned char SCRAMBLER[] = {
-	0x00U, 0x00U, 0xD6U, 0xB5U, 0xE2U, 0x30U, 0x82U, 0xFFU, 0x84U, 0x62U, 0xBAU, 0x4EU, 0x96U, 0x90U, 0xD8U, 0x98U, 0xDDU,
-	0x5DU, 0x0CU, 0xC8U, 0x52U, 0x43U, 0x91U, 0x1DU, 0xF8U, 0x6EU, 0x68U, 0x2FU, 0x35U, 0xDAU, 0x14U, 0xEAU, 0xCDU, 0x76U,
-	0x19U, 0x8DU, 0xD5U, 0x80U, 0xD1U, 0x33U, 0x87U, 0x13U, 0x57U, 0x18U, 0x2DU, 0x29U, 0x78U, 0xC3U};
-
 const unsigned char BIT_MASK_TABLE[] = { 0x80U, 0x40U, 0x20U, 0x10U, 0x08U, 0x04U, 0x02U, 0x01U };
 
 #define WRITE_BIT(p,i,b) p[(i)>>3] = (b) ? (p[(i)>>3] | BIT_MASK_TABLE[(i)&7]) : (p[(i)>>3] & ~BIT_MASK_TABLE[(i)&7])
 #define READ_BIT(p,i)    (p[(i)>>3] & BIT_MASK_TABLE[(i)&7])
 
-CM17RX::CM17RX(const std::string& callsign, CRSSIInterpolator* rssiMapper, bool bleep, CCodec2& codec3200, CCodec2& codec1600) :
-m_3200(codec3200),
-m_1600(codec1600),
+CM17RX::CM17RX(const std::string& callsign, CRSSIInterpolator* rssiMapper, bool bleep) :
+m_3200(true),
+m_1600(false),
 m_callsign(callsign),
 m_bleep(bleep),
 m_volume(1.0F),
@@ -90,10 +81,24 @@ m_maxRSSI(0U),
 m_minRSSI(0U),
 m_aveRSSI(0U),
 m_rssiCount(0U),
+m_resamplerType(RT_POLYPHASE),
+m_polyphase(),
 m_resampler(NULL),
 m_error(0),
 m_latitude(),
-m_longitude()
+m_longitude(),
+m_gpsMutex(),
+m_conv(),
+m_jitterTarget(0U),
+m_jitterDepth(0.0F),
+m_stretches(0U),
+m_compressions(0U),
+m_concealBER(0U),
+m_hangTimer(1000U),
+m_hangMS(0U),
+m_fn(),
+m_concealed(0U),
+m_concealments(0U)
 {
 	m_text = new char[4U * M17_META_LENGTH_BYTES];
 
@@ -126,10 +131,29 @@ void CM17RX::setVolume(unsigned int percentage)
 
 void CM17RX::setGPS(float latitude, float longitude)
 {
+	std::lock_guard<std::mutex> lock(m_gpsMutex);
+
 	m_latitude  = latitude;
 	m_longitude = longitude;
 }
 
+void CM17RX::setResampler(RESAMPLER_TYPE type)
+{
+	m_resamplerType = type;
+}
+
+void CM17RX::setJitter(unsigned int targetMS)
+{
+	m_jitterTarget = targetMS;
+}
+
+void CM17RX::setConcealment(unsigned int berPercent, unsigned int hangMS)
+{
+	m_concealBER = berPercent;
+
+	m_hangTimer.setTimeout(hangMS / 1000U, hangMS % 1000U);
+}
+
 unsigned int CM17RX::read(float* audio, unsigned int len)
 {
 	assert(audio != NULL);
@@ -156,22 +180,79 @@ unsigned int CM17RX::read(float* audio, unsigned int len)
 	return len;
 }
 
+void CM17RX::clock(unsigned int ms)
+{
+	if (!m_hangTimer.isRunning())
+		return;
+
+	m_hangTimer.clock(ms);
+
+	// Keep filling the frame slots while the signal is lost
+	m_hangMS += ms;
+	while (m_hangMS >= PLC_FRAME_MS) {
+		m_hangMS -= PLC_FRAME_MS;
+
+		concealFrame();
+
+		if (m_fn)
+			m_fn = (m_fn.value() + 1U) & 0x7FFFU;
+	}
+
+	if (m_hangTimer.hasExpired()) {
+		m_hangTimer.stop();
+		lost();
+	}
+}
+
+bool CM17RX::isHolding()
+{
+	return m_hangTimer.isRunning();
+}
+
 bool CM17RX::write(unsigned char* data, unsigned int len)
 {
 	assert(data != NULL);
 	assert(len > 0U);
 
+	return process(data, len, NULL);
+}
+
+bool CM17RX::writeSoft(unsigned char type, const uint8_t* soft)
+{
+	assert(soft != NULL);
+
+	// Hard decisions for the sync and the LICH
+	unsigned char data[M17_FRAME_LENGTH_BYTES + 2U];
+	data[0U] = type;
+	data[1U] = 0x00U;
+
+	unsigned char* frame = data + 2U;
+	for (unsigned int i = 0U; i < M17_FRAME_LENGTH_BITS; i++)
+		WRITE_BIT(frame, i, soft[i] >= 0x80U);
+
+	return process(data, M17_FRAME_LENGTH_BYTES + 2U, soft);
+}
+
+bool CM17RX::process(unsigned char* data, unsigned int len, const uint8_t* soft)
+{
+	assert(data != NULL);
+	assert(len > 0U);
+
 	unsigned char type = data[0U];
 
 	if (type == TAG_LOST && (m_state == RS_RF_AUDIO || m_state == RS_RF_AUDIO_DATA)) {
-		std::string source = m_lsf.getSource();
-		std::string dest   = m_lsf.getDest();
+		if (m_hangTimer.isRunning())
+			return false;
 
-		if (m_rssi != 0U)
-			LogMessage("Transmission lost from %s to %s, %.1f seconds, BER: %.1f%%, RSSI: -%u/-%u/-%u dBm", source.c_str(), dest.c_str(), float(m_frames) / 25.0F, float(m_errs * 100U) / float(m_bits), m_minRSSI, m_maxRSSI, m_aveRSSI / m_rssiCount);
-		else
-			LogMessage("Transmission lost from %s to %s, %.1f seconds, BER: %.1f%%", source.c_str(), dest.c_str(), float(m_frames) / 25.0F, float(m_errs * 100U) / float(m_bits));
-		end();
+		// Hold the stream open in case the signal comes back
+		m_hangTimer.start();
+		if (m_hangTimer.isRunning()) {
+			LogDebug("Signal lost, holding the transmission open");
+			m_hangMS = 0U;
+			return false;
+		}
+
+		lost();
 		return false;
 	}
 
@@ -185,6 +266,16 @@ bool CM17RX::write(unsigned char* data, unsigned int len)
 		return false;
 	}
 
+	// The signal has come back, a new link setup is a new transmission
+	if (m_hangTimer.isRunning()) {
+		m_hangTimer.stop();
+
+		if (type == TAG_HEADER)
+			lost();
+		else
+			LogDebug("Signal regained, resuming the transmission");
+	}
+
 	// Have we got RSSI bytes on the end?
 	if (len == (M17_FRAME_LENGTH_BYTES + 4U)) {
 		uint16_t raw = 0U;
@@ -212,15 +303,25 @@ bool CM17RX::write(unsigned char* data, unsigned int len)
 	}
 
 	unsigned char temp[M17_FRAME_LENGTH_BYTES];
-	decorrelator(data + 2U, temp);
-	interleaver(temp, data + 2U);
+	CM17Framing::decorrelate(data + 2U, temp);
+	CM17Framing::interleave(temp, data + 2U);
+
+	uint8_t softFrame[M17_FRAME_LENGTH_BITS];
+	if (soft != NULL) {
+		uint8_t softTemp[M17_FRAME_LENGTH_BITS];
+		CM17Framing::decorrelateSoft(soft, softTemp);
+		CM17Framing::interleaveSoft(softTemp, softFrame);
+	}
 
 	if (m_state == RS_RF_LISTENING && data[0U] == TAG_HEADER) {
 		m_lsf.reset();
 
-		CM17Convolution conv;
 		unsigned char frame[M17_LSF_LENGTH_BYTES];
-		unsigned int ber = conv.decodeLinkSetup(data + 2U + M17_SYNC_LENGTH_BYTES, frame);
+		unsigned int ber;
+		if (soft != NULL)
+			ber = m_conv.decodeLinkSetupSoft(softFrame + M17_SYNC_LENGTH_BITS, frame);
+		else
+			ber = m_conv.decodeLinkSetup(data + 2U + M17_SYNC_LENGTH_BYTES, frame);
 
 		bool valid = CM17CRC::checkCRC16(frame, M17_LSF_LENGTH_BYTES);
 		if (valid) {
@@ -249,7 +350,12 @@ bool CM17RX::write(unsigned char* data, unsigned int len)
 			m_callsigns.clear();
 			::memset(m_text, 0x00U, 4U * M17_META_LENGTH_BYTES);
 
-			addSilence(SILENCE_BLOCK_COUNT);
+			// Nothing to conceal from until the first good frame
+			m_fn.reset();
+			m_concealed    = PLC_MAX_FRAMES;
+			m_concealments = 0U;
+
+			startJitter();
 
 			LogDebug("Received link setup, BER: %u/368 (%.1f%%)", ber, float(ber) / 3.68F);
 
@@ -266,19 +372,14 @@ bool CM17RX::write(unsigned char* data, unsigned int len)
 	}
 
 	if (m_state == RS_RF_LATE_ENTRY && data[0U] == TAG_DATA) {
-		unsigned int lich1, lich2, lich3, lich4;
-		bool valid1 = CGolay24128::decode24128(data + 2U + M17_SYNC_LENGTH_BYTES + 0U, lich1);
-		bool valid2 = CGolay24128::decode24128(data + 2U + M17_SYNC_LENGTH_BYTES + 3U, lich2);
-		bool valid3 = CGolay24128::decode24128(data + 2U + M17_SYNC_LENGTH_BYTES + 6U, lich3);
-		bool valid4 = CGolay24128::decode24128(data + 2U + M17_SYNC_LENGTH_BYTES + 9U, lich4);
-
-		if (!valid1 || !valid2 || !valid3 || !valid4)
+		unsigned int codes[4U];
+		if (!CGolay24128::decode24128x4(data + 2U + M17_SYNC_LENGTH_BYTES, codes))
 			return false;
 
 		unsigned char lich[M17_LICH_FRAGMENT_LENGTH_BYTES];
-		CM17Utils::combineFragmentLICH(lich1, lich2, lich3, lich4, lich);
+		CM17Utils::combineFragmentLICH(codes[0U], codes[1U], codes[2U], codes[3U], lich);
 
-		unsigned int n = (lich4 >> 5) & 0x07U;
+		unsigned int n = (codes[3U] >> 5) & 0x07U;
 		m_lsf.setFragment(lich, n);
 
 		bool valid = m_lsf.isValid();
@@ -306,7 +407,12 @@ bool CM17RX::write(unsigned char* data, unsigned int len)
 			m_callsigns.clear();
 			::memset(m_text, 0x00U, 4U * M17_META_LENGTH_BYTES);
 
-			addSilence(SILENCE_BLOCK_COUNT);
+			// Nothing to conceal from until the first good frame
+			m_fn.reset();
+			m_concealed    = PLC_MAX_FRAMES;
+			m_concealments = 0U;
+
+			startJitter();
 
 			// Fall through
 		} else {
@@ -317,9 +423,12 @@ bool CM17RX::write(unsigned char* data, unsigned int len)
 	if ((m_state == RS_RF_AUDIO || m_state == RS_RF_AUDIO_DATA) && data[0U] == TAG_DATA) {
 		processRunningLSF(data + 2U + M17_SYNC_LENGTH_BYTES);
 
-		CM17Convolution conv;
 		unsigned char frame[M17_FN_LENGTH_BYTES + M17_PAYLOAD_LENGTH_BYTES];
-		unsigned int ber = conv.decodeData(data + 2U + M17_SYNC_LENGTH_BYTES + M17_LICH_FRAGMENT_FEC_LENGTH_BYTES, frame);
+		unsigned int ber;
+		if (soft != NULL)
+			ber = m_conv.decodeDataSoft(softFrame + M17_SYNC_LENGTH_BITS + M17_LICH_FRAGMENT_FEC_LENGTH_BITS, frame);
+		else
+			ber = m_conv.decodeData(data + 2U + M17_SYNC_LENGTH_BYTES + M17_LICH_FRAGMENT_FEC_LENGTH_BYTES, frame);
 
 		uint16_t fn = (frame[0U] << 8) + (frame[1U] << 0);
 
@@ -328,40 +437,50 @@ bool CM17RX::write(unsigned char* data, unsigned int len)
 		m_bits += 272U;
 		m_errs += ber;
 
-		// A valid M17 audio frame
-		short audio[CODEC_BLOCK_SIZE];
-		if (m_state == RS_RF_AUDIO) {
-			m_3200.codec2_decode(audio + 0U,   frame + 2U);
-			m_3200.codec2_decode(audio + 160U, frame + 2U + 8U);
-		} else {
-			m_1600.codec2_decode(audio + 0U,   frame + 2U);
-			m_1600.codec2_decode(audio + 160U, frame + 2U + 4U);
-			CUtils::dump(1U, "Data Payload", frame + 2U + 8U, 8U);
+		// The frame number of a corrupted frame can't be trusted either
+		bool corrupt = m_concealBER > 0U && (ber * 100U) > (m_concealBER * 272U);
+
+		if (corrupt) {
+			if (m_fn)
+				m_fn = (m_fn.value() + 1U) & 0x7FFFU;
+
+			concealFrame();
+
+			return true;
 		}
 
-		// Adjust the volume, and convert to float
-		float f8000[CODEC_BLOCK_SIZE];
-		for (unsigned int i = 0U; i < CODEC_BLOCK_SIZE; i++)
-			f8000[i] = (float(audio[i]) * m_volume) / 32768.0F;
+		fn &= 0x7FFFU;
 
-		float f48000[SOUNDCARD_BLOCK_SIZE];
+		// Fill any frames that never arrived to keep the audio in step, without
+		// concealment the frame numbers of damaged frames aren't trusted either
+		if (m_concealBER > 0U && m_fn) {
+			unsigned int missing = (fn - m_fn.value() - 1U) & 0x7FFFU;
+			if (missing > 0U && missing <= PLC_MAX_GAP) {
+				LogDebug("Concealing %u missing frames before FN: %u", missing, fn);
+				for (unsigned int i = 0U; i < missing; i++)
+					concealFrame();
+			}
+		}
 
-		SRC_DATA data;
-		data.data_in       = f8000;
-		data.data_out      = f48000;
-		data.input_frames  = CODEC_BLOCK_SIZE;
-		data.output_frames = SOUNDCARD_BLOCK_SIZE;
-		data.end_of_input  = 0;
-		data.src_ratio     = double(SOUNDCARD_SAMPLE_RATE) / double(CODEC_SAMPLE_RATE);
+		m_fn = fn;
 
-		int ret = ::src_process(m_resampler, &data);
-		if (ret != 0)
-			LogError("Error from the RX resampler - %d - %s", ret, ::src_strerror(ret));
+		// A valid M17 audio frame, decoded straight to float at the volume
+		float audio[CODEC_BLOCK_SIZE];
+		if (m_state == RS_RF_AUDIO) {
+			m_3200.codec2_decode(audio, frame + 2U, 2U, m_volume / 32768.0F);
+		} else {
+			m_1600.codec2_decode(audio, frame + 2U, 1U, m_volume / 32768.0F);
+			CUtils::dump(1U, "Data Payload", frame + 2U + 8U, 8U);
+		}
 
-		writeQueue(f48000, SOUNDCARD_BLOCK_SIZE);
+		m_concealed = 0U;
 
+		// Only received audio counts towards the length, concealed frames are
+		// counted in m_concealments
 		m_frames++;
 
+		writeAudio(audio);
+
 		return true;
 	}
 
@@ -373,6 +492,10 @@ bool CM17RX::write(unsigned char* data, unsigned int len)
 			LogMessage("Received end of transmission from %s to %s, %.1f seconds, BER: %.1f%%, RSSI: -%u/-%u/-%u dBm", source.c_str(), dest.c_str(), float(m_frames) / 25.0F, float(m_errs * 100U) / float(m_bits), m_minRSSI, m_maxRSSI, m_aveRSSI / m_rssiCount);
 		else
 			LogMessage("Received end of transmission from %s to %s, %.1f seconds, BER: %.1f%%", source.c_str(), dest.c_str(), float(m_frames) / 25.0F, float(m_errs * 100U) / float(m_bits));
+
+		if (m_jitterTarget > 0U)
+			LogDebug("Jitter buffer, %u frames stretched, %u frames compressed", m_stretches, m_compressions);
+
 		end();
 
 		return true;
@@ -381,9 +504,25 @@ bool CM17RX::write(unsigned char* data, unsigned int len)
 	return false;
 }
 
+void CM17RX::lost()
+{
+	std::string source = m_lsf.getSource();
+	std::string dest   = m_lsf.getDest();
+
+	if (m_rssi != 0U)
+		LogMessage("Transmission lost from %s to %s, %.1f seconds, BER: %.1f%%, RSSI: -%u/-%u/-%u dBm", source.c_str(), dest.c_str(), float(m_frames) / 25.0F, float(m_errs * 100U) / float(m_bits), m_minRSSI, m_maxRSSI, m_aveRSSI / m_rssiCount);
+	else
+		LogMessage("Transmission lost from %s to %s, %.1f seconds, BER: %.1f%%", source.c_str(), dest.c_str(), float(m_frames) / 25.0F, float(m_errs * 100U) / float(m_bits));
+
+	end();
+}
+
 void CM17RX::end()
 {
 	if (m_state == RS_RF_AUDIO || m_state == RS_RF_AUDIO_DATA) {
+		if (m_concealments > 0U)
+			LogDebug("%u frames concealed", m_concealments);
+
 		if (m_bleep)
 			addBleep();
 
@@ -399,6 +538,98 @@ void CM17RX::end()
 	m_lsf.reset();
 }
 
+unsigned int CM17RX::adjustJitter(const float* in, float* out)
+{
+	assert(in != NULL);
+	assert(out != NULL);
+
+	if (m_jitterTarget == 0U) {
+		::memcpy(out, in, CODEC_BLOCK_SIZE * sizeof(float));
+		return CODEC_BLOCK_SIZE;
+	}
+
+	// The queue depth when a frame arrives measures the modem against the sound card clock
+	const unsigned int sampleRate = m_resamplerType == RT_NONE ? CODEC_SAMPLE_RATE : SOUNDCARD_SAMPLE_RATE;
+
+	float depth = (float(m_queue.dataSize()) * 1000.0F) / float(sampleRate);
+	m_jitterDepth += (depth - m_jitterDepth) * JITTER_SMOOTHING;
+
+	float target = float(m_jitterTarget);
+
+	// Stretch straight away if the queue is about to run dry
+	if (depth < JITTER_LOW_MS || m_jitterDepth < (target - JITTER_HYSTERESIS_MS)) {
+		m_stretches++;
+		return CTimeStretch::stretch(in, CODEC_BLOCK_SIZE, out);
+	}
+
+	if (m_jitterDepth > (target + JITTER_HYSTERESIS_MS)) {
+		m_compressions++;
+		return CTimeStretch::compress(in, CODEC_BLOCK_SIZE, out);
+	}
+
+	::memcpy(out, in, CODEC_BLOCK_SIZE * sizeof(float));
+
+	return CODEC_BLOCK_SIZE;
+}
+
+void CM17RX::writeAudio(const float* audio)
+{
+	assert(audio != NULL);
+
+	float f8000[CODEC_BLOCK_SIZE + TS_MAX_PERIOD];
+	unsigned int len = adjustJitter(audio, f8000);
+
+	// The sound card is running at the codec rate
+	if (m_resamplerType == RT_NONE) {
+		writeQueue(f8000, len);
+		return;
+	}
+
+	float f48000[(CODEC_BLOCK_SIZE + TS_MAX_PERIOD) * RESAMPLER_RATIO];
+
+	if (m_resamplerType == RT_POLYPHASE) {
+		m_polyphase.interpolate(f8000, len, f48000);
+	} else {
+		SRC_DATA data;
+		data.data_in       = f8000;
+		data.data_out      = f48000;
+		data.input_frames  = len;
+		data.output_frames = len * RESAMPLER_RATIO;
+		data.end_of_input  = 0;
+		data.src_ratio     = double(SOUNDCARD_SAMPLE_RATE) / double(CODEC_SAMPLE_RATE);
+
+		int ret = ::src_process(m_resampler, &data);
+		if (ret != 0)
+			LogError("Error from the RX resampler - %d - %s", ret, ::src_strerror(ret));
+	}
+
+	writeQueue(f48000, len * RESAMPLER_RATIO);
+}
+
+void CM17RX::concealFrame()
+{
+	float audio[CODEC_BLOCK_SIZE];
+
+	if (m_concealed < PLC_MAX_FRAMES) {
+		CCodec2Decoder& codec = m_state == RS_RF_AUDIO ? m_3200 : m_1600;
+
+		// Repeat the last frame at full level, then fade it out
+		float fade = m_concealed == 0U ? 1.0F : PLC_FADE;
+
+		unsigned int n = codec.codec2_samples_per_frame();
+		for (unsigned int i = 0U; i < CODEC_BLOCK_SIZE; i += n)
+			codec.codec2_conceal(audio + i, fade, m_volume / 32768.0F);
+	} else {
+		for (unsigned int i = 0U; i < CODEC_BLOCK_SIZE; i++)
+			audio[i] = 0.0F;
+	}
+
+	m_concealed++;
+	m_concealments++;
+
+	writeAudio(audio);
+}
+
 void CM17RX::writeQueue(const float *audio, unsigned int len)
 {
 	assert(audio != NULL);
@@ -447,28 +678,6 @@ bool CM17RX::processHeader(bool lateEntry)
 	return true;
 }
 
-void CM17RX::interleaver(const unsigned char* in, unsigned char* out) const
-{
-	assert(in != NULL);
-	assert(out != NULL);
-
-	for (unsigned int i = 0U; i < (M17_FRAME_LENGTH_BITS - M17_SYNC_LENGTH_BITS); i++) {
-		unsigned int n1 = i + M17_SYNC_LENGTH_BITS;
-		bool b = READ_BIT(in, n1) != 0U;
-		unsigned int n2 = INTERLEAVER[i] + M17_SYNC_LENGTH_BITS;
-		WRITE_BIT(out, n2, b);
-	}
-}
-
-void CM17RX::decorrelator(const unsigned char* in, unsigned char* out) const
-{
-	assert(in != NULL);
-	assert(out != NULL);
-
-	for (unsigned int i = M17_SYNC_LENGTH_BYTES; i < M17_FRAME_LENGTH_BYTES; i++)
-		out[i] = in[i] ^ SCRAMBLER[i];
-}
-
 void CM17RX::processLSF(const CM17LSF& lsf)
 {
 	if (lsf.getEncryptionType() == M17_ENCRYPTION_TYPE_NONE) {
@@ -542,13 +751,16 @@ void CM17RX::processLSF(const CM17LSF& lsf)
 						speed = float(meta[13U]) * 1.602F;
 					}
 
-					LogDebug("RX GPS Data: Lat=%fdeg Long=%fdeg Alt=%fm Speed=%fkm/h Track=%fdeg Type=%s", latitude, longitude, altitude.value(), speed.value(), track.value(), type.c_str());
+					LogDebug("RX GPS Data: Lat=%fdeg Long=%fdeg Alt=%fm Speed=%fkm/h Track=%fdeg Type=%s", latitude, longitude, altitude.value_or(0.0F), speed.value_or(0.0F), track.value_or(0.0F), type.c_str());
 
 					std::string locator = calcLocator(latitude, longitude);
 
 					std::optional<float> bearing, distance;
-					if (m_latitude && m_longitude)
-						calcBD(m_latitude, m_longitude, latitude, longitude, bearing, distance);
+					{
+						std::lock_guard<std::mutex> lock(m_gpsMutex);
+						if (m_latitude && m_longitude)
+							calcBD(m_latitude, m_longitude, latitude, longitude, bearing, distance);
+					}
 
 					m_callback->gpsCallback(latitude, longitude, locator, altitude, speed, track, bearing, distance);
 				}
@@ -599,19 +811,14 @@ void CM17RX::processLSF(const CM17LSF& lsf)
 
 void CM17RX::processRunningLSF(const unsigned char* fragment)
 {
-	unsigned int lich1, lich2, lich3, lich4;
-	bool valid1 = CGolay24128::decode24128((unsigned char *)(fragment + 0U), lich1);
-	bool valid2 = CGolay24128::decode24128((unsigned char *)(fragment + 3U), lich2);
-	bool valid3 = CGolay24128::decode24128((unsigned char *)(fragment + 6U), lich3);
-	bool valid4 = CGolay24128::decode24128((unsigned char *)(fragment + 9U), lich4);
-
-	if (!valid1 || !valid2 || !valid3 || !valid4)
+	unsigned int codes[4U];
+	if (!CGolay24128::decode24128x4(fragment, codes))
 		return;
 
 	unsigned char lich[M17_LICH_FRAGMENT_LENGTH_BYTES];
-	CM17Utils::combineFragmentLICH(lich1, lich2, lich3, lich4, lich);
+	CM17Utils::combineFragmentLICH(codes[0U], codes[1U], codes[2U], codes[3U], lich);
 
-	unsigned int n = (lich4 >> 5) & 0x07U;
+	unsigned int n = (codes[3U] >> 5) & 0x07U;
 	m_running.setFragment(lich, n);
 
 	bool valid = m_running.isValid();
@@ -623,12 +830,14 @@ void CM17RX::processRunningLSF(const unsigned char* fragment)
 
 void CM17RX::addBleep()
 {
-	const unsigned int length = SOUNDCARD_SAMPLE_RATE / BLEEP_FREQ;
-	const unsigned int total  = (SOUNDCARD_SAMPLE_RATE * BLEEP_LENGTH) / 1000U;
+	const unsigned int sampleRate = m_resamplerType == RT_NONE ? CODEC_SAMPLE_RATE : SOUNDCARD_SAMPLE_RATE;
+
+	const unsigned int length = sampleRate / BLEEP_FREQ;
+	const unsigned int total  = (sampleRate * BLEEP_LENGTH) / 1000U;
 
 	float step = (2.0F * M_PI) / float(length);
 
-	float audio[total];
+	float audio[(SOUNDCARD_SAMPLE_RATE * BLEEP_LENGTH) / 1000U];
 
 	for (unsigned int i = 0U; i < total; i++)
 		audio[i] = ::sinf(float(i) * step) * BLEEP_AMPL * m_volume;
@@ -646,14 +855,32 @@ void CM17RX::addEnd()
 	writeQueue(audio, 1U);
 }
 
-void CM17RX::addSilence(unsigned int n)
+void CM17RX::startJitter()
 {
-	const float SILENCE = 0.0F;
+	m_stretches    = 0U;
+	m_compressions = 0U;
 
-	for (unsigned int i = 0U; i < n; i++) {
-		for (unsigned int j = 0U; j < SOUNDCARD_BLOCK_SIZE; j++)
-			writeQueue(&SILENCE, 1U);
+	if (m_jitterTarget == 0U) {
+		addSilence(SILENCE_BLOCK_COUNT);
+		return;
 	}
+
+	// Prime the queue to the target depth, rounded up to whole blocks
+	const unsigned int blockMS = (CODEC_BLOCK_SIZE * 1000U) / CODEC_SAMPLE_RATE;
+
+	addSilence((m_jitterTarget + blockMS - 1U) / blockMS);
+
+	m_jitterDepth = float(m_jitterTarget);
+}
+
+void CM17RX::addSilence(unsigned int n)
+{
+	const float SILENCE[SOUNDCARD_BLOCK_SIZE] = { 0.0F };
+
+	const unsigned int blockSize = m_resamplerType == RT_NONE ? CODEC_BLOCK_SIZE : SOUNDCARD_BLOCK_SIZE;
+
+	for (unsigned int i = 0U; i < n; i++)
+		writeQueue(SILENCE, blockSize);
 }
 
 void CM17RX::calcBD(const std::optional<float>& srcLat, const std::optional<float>& srcLon,
@@ -22,40 +22,65 @@
 #include "RSSIInterpolator.h"
 #include "StatusCallback.h"
 #include "codec2/codec2.h"
-#include "RingBuffer.h"
+#include "SPSCRingBuffer.h"
+#include "M17Convolution.h"
+#include "TimeStretch.h"
+#include "Resampler.h"
 #include "M17Defines.h"
 #include "Defines.h"
 #include "M17LSF.h"
 #include "Modem.h"
+#include "Timer.h"
 
 #include <samplerate.h>
 
 #include <string>
+#include <mutex>
+#include <atomic>
 #include <optional>
 
 class CM17RX {
 public:
-	CM17RX(const std::string& callsign, CRSSIInterpolator* rssiMapper, bool bleep, CCodec2& codec3200, CCodec2& codec1600);
+	CM17RX(const std::string& callsign, CRSSIInterpolator* rssiMapper, bool bleep);
 	~CM17RX();
 
 	void setStatusCallback(IStatusCallback* callback);
 
+	// These are safe to call while another thread is decoding
 	unsigned int getVolume() const;
-
 	void setVolume(unsigned int percentage);
-
 	void setGPS(float latitude, float longitude);
 
+	void setResampler(RESAMPLER_TYPE type);
+
+	// The target depth of the RX audio queue, time stretching is used to
+	// hold it there, 0 disables it and uses a fixed 200ms of padding
+	void setJitter(unsigned int targetMS);
+
+	// Frames with a BER above the percentage and missing frames are
+	// concealed, 0 disables it. After a lost signal the stream is held open
+	// for the hang time in case it comes back, 0 ends it straight away
+	void setConcealment(unsigned int berPercent, unsigned int hangMS);
+
 	bool write(unsigned char* data, unsigned int len);
 
+	// A whole frame as soft bits, one per byte from 0x00 (a certain 0) to
+	// 0xFF (a certain 1), for sources such as recorded baseband
+	bool writeSoft(unsigned char type, const uint8_t* soft);
+
 	unsigned int read(float* audio, unsigned int len);
 
+	void clock(unsigned int ms);
+
+	// True while a lost transmission is being held open
+	bool isHolding();
+
 private:
-	CCodec2&             m_3200;
-	CCodec2&             m_1600;
+	CCodec2Decoder       m_3200;
+	CCodec2Decoder       m_1600;
 	std::string          m_callsign;
 	bool                 m_bleep;
-	float                m_volume;
+	std::atomic<float>   m_volume;
 	IStatusCallback*     m_callback;
 	RPT_RF_STATE         m_state;
 	unsigned int         m_frames;
@@ -66,24 +91,43 @@ private:
 	uint8_t              m_textBitMap;
 	char*                m_text;
 	std::string          m_callsigns;
-	CRingBuffer<float>   m_queue;
+	CSPSCRingBuffer<float> m_queue;
 	CRSSIInterpolator*   m_rssiMapper;
 	unsigned char        m_rssi;
 	unsigned char        m_maxRSSI;
 	unsigned char        m_minRSSI;
 	unsigned int         m_aveRSSI;
 	unsigned int         m_rssiCount;
+	RESAMPLER_TYPE       m_resamplerType;
+	CResampler           m_polyphase;
 	SRC_STATE*           m_resampler;
 	int                  m_error;
 	std::optional<float> m_latitude;
 	std::optional<float> m_longitude;
+	std::mutex           m_gpsMutex;
+	CM17Convolution      m_conv;
+	unsigned int         m_jitterTarget;
+	float                m_jitterDepth;
+	unsigned int         m_stretches;
+	unsigned int         m_compressions;
+	unsigned int         m_concealBER;
+	CTimer               m_hangTimer;
+	unsigned int         m_hangMS;
+	std::optional<uint16_t> m_fn;
+	unsigned int         m_concealed;
+	unsigned int         m_concealments;
 
 	void writeQueue(const float *audio, unsigned int len);
 
-	bool processHeader(bool lateEntry);
+	void writeAudio(const float* audio);
+	void concealFrame();
 
-	void interleaver(const unsigned char* in, unsigned char* out) const;
-	void decorrelator(const unsigned char* in, unsigned char* out) const;
+	void         startJitter();
+	unsigned int adjustJitter(const float* in, float* out);
+
+	bool process(unsigned char* data, unsigned int len, const uint8_t* soft);
+
+	bool processHeader(bool lateEntry);
 
 	void processRunningLSF(const unsigned char* fragment);
 	void processLSF(const CM17LSF& lsf);
@@ -94,6 +138,7 @@ private:
 			float dstLat, float dstLon, std::optional<float>& bearing, std::optional<float>& distance) const;
 	std::string calcLocator(float latitude, float longitude) const;
 
+	void lost();
 	void end();
 
 	void addBleep();
@@ -20,8 +20,10 @@
 #define	M17TX_H
 
 #include "codec2/codec2.h"
+#include "M17Convolution.h"
+#include "Resampler.h"
 #include "M17Defines.h"
-#include "RingBuffer.h"
+#include "SPSCRingBuffer.h"
 #include "Defines.h"
 #include "M17LSF.h"
 #include "Modem.h"
@@ -29,6 +31,8 @@
 #include <samplerate.h>
 
 #include <string>
+#include <mutex>
+#include <atomic>
 #include <vector>
 #include <optional>
 
@@ -41,13 +45,19 @@ enum TX_STATUS {
 
 class CM17TX {
 public:
-	CM17TX(const std::string& callsign, const std::string& text, unsigned int micGain, CCodec2& codec3200, CCodec2& codec1600);
+	CM17TX(const std::string& callsign, const std::string& text, unsigned int micGain);
 	~CM17TX();
 
+	// These and start() and end() are called from the main loop, they hold
+	// the same lock as process() so none of them lands part way through an
+	// encode
 	void setParams(unsigned int can, unsigned int mode);
 
 	void setDestination(const std::string& callsign);
 
+	// Only before process() is first called
+	void setResampler(RESAMPLER_TYPE type);
+
 	void setGPS(float latitude, float longitude,
 			std::optional<float>& altitude,
 			std::optional<float>& speed, std::optional<float>& track,
@@ -55,9 +65,12 @@ public:
 
 	void start();
 
+	// Called from the audio capture thread
 	void write(const float* audio, unsigned int len);
 
-	void process();
+	// Encodes one block of audio, false if there isn't a whole block or the
+	// output queue is full. It may run on a different thread to the rest
+	bool process();
 
 	void end();
 
@@ -66,16 +79,17 @@ public:
 	bool isTX() const;
 
 private:
-	CCodec2&                   m_3200;
-	CCodec2&                   m_1600;
+	CCodec2Encoder             m_3200;
+	CCodec2Encoder             m_1600;
 	unsigned int               m_mode;
 	std::string                m_source;
 	std::string                m_dest;
 	float                      m_micGain;
 	unsigned int               m_can;
-	TX_STATUS                  m_status;
-	CRingBuffer<float>         m_audio;
-	CRingBuffer<unsigned char> m_queue;
+	std::atomic<TX_STATUS>     m_status;
+	CSPSCRingBuffer<float>     m_audio;
+	CSPSCRingBuffer<unsigned char> m_queue;
+	std::mutex                 m_mutex;
 	uint16_t                   m_frames;
 	CM17LSF*                   m_currLSF;
 	std::vector<CM17LSF*>::const_iterator m_currTextLSF;
@@ -83,14 +97,14 @@ private:
 	bool                       m_sendingGPS;
 	CM17LSF*                   m_gpsLSF;
 	unsigned int               m_lsfN;
+	RESAMPLER_TYPE             m_resamplerType;
+	CResampler                 m_polyphase;
 	SRC_STATE*                 m_resampler;
 	int                        m_error;
+	CM17Convolution            m_conv;
 
 	void writeQueue(const unsigned char* data);
 
-	void interleaver(const unsigned char* in, unsigned char* out) const;
-	void decorrelator(const unsigned char* in, unsigned char* out) const;
-
 	void addLinkSetupSync(unsigned char* data);
 	void addStreamSync(unsigned char* data);
 	void addEOTSync(unsigned char* data);
@@ -212,6 +212,7 @@ m_tx(false),
 m_cd(false),
 m_lockout(false),
 m_error(false),
+m_resets(0U),
 m_mode(MODE_IDLE),
 m_hwType(HWT_UNKNOWN),
 m_ax25RXTwist(0),
@@ -475,6 +476,8 @@ void CModem::clock(unsigned int ms)
 		CThread::sleep(2000U);		// 2s
 		while (!open())
 			CThread::sleep(5000U);	// 5s
+
+		m_resets++;
 	}
 
 	RESP_TYPE_MMDVM type = getResponse();
@@ -2559,6 +2562,18 @@ HW_TYPE CModem::getHWType() const
 	return m_hwType;
 }
 
+int CModem::getFD() const
+{
+	assert(m_port != NULL);
+
+	return m_port->getFD();
+}
+
+unsigned int CModem::getResets() const
+{
+	return m_resets;
+}
+
 unsigned char CModem::getMode() const
 {
 	return m_mode;
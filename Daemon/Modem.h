@@ -142,6 +142,9 @@ public:
 
 	HW_TYPE getHWType() const;
 
+	int getFD() const;
+	unsigned int getResets() const;
+
 	void clock(unsigned int ms);
 
 	void close();
@@ -236,6 +239,7 @@ private:
 	bool                       m_cd;
 	bool                       m_lockout;
 	bool                       m_error;
+	unsigned int               m_resets;
 	unsigned char              m_mode;
 	HW_TYPE                    m_hwType;
 	int                        m_ax25RXTwist;
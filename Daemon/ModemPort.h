@@ -31,6 +31,8 @@ public:
 
 	virtual void close() = 0;
 
+	virtual int getFD() const = 0;
+
 private:
 };
 
@@ -0,0 +1,173 @@
+/*
+ *   Copyright (C) 2022 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include "Reactor.h"
+#include "Log.h"
+
+#include <cstdio>
+#include <cassert>
+#include <cerrno>
+#include <cstdint>
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+const unsigned int MAX_EVENTS = 16U;
+
+CReactor::CReactor(unsigned int tickMS) :
+m_tickMS(tickMS),
+m_epollFD(-1),
+m_eventFD(-1),
+m_timerFD(-1)
+{
+	assert(tickMS > 0U);
+}
+
+CReactor::~CReactor()
+{
+}
+
+bool CReactor::open()
+{
+	m_epollFD = ::epoll_create1(EPOLL_CLOEXEC);
+	if (m_epollFD == -1) {
+		LogError("Cannot create the epoll instance, errno=%d", errno);
+		return false;
+	}
+
+	m_eventFD = ::eventfd(0U, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (m_eventFD == -1) {
+		LogError("Cannot create the eventfd, errno=%d", errno);
+		close();
+		return false;
+	}
+
+	m_timerFD = ::timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+	if (m_timerFD == -1) {
+		LogError("Cannot create the timerfd, errno=%d", errno);
+		close();
+		return false;
+	}
+
+	struct itimerspec spec;
+	spec.it_interval.tv_sec  = m_tickMS / 1000U;
+	spec.it_interval.tv_nsec = (m_tickMS % 1000U) * 1000000L;
+	spec.it_value            = spec.it_interval;
+
+	int ret = ::timerfd_settime(m_timerFD, 0, &spec, NULL);
+	if (ret == -1) {
+		LogError("Cannot start the timerfd, errno=%d", errno);
+		close();
+		return false;
+	}
+
+	if (!addFD(m_eventFD) || !addFD(m_timerFD)) {
+		close();
+		return false;
+	}
+
+	return true;
+}
+
+bool CReactor::addFD(int fd)
+{
+	assert(m_epollFD != -1);
+
+	if (fd < 0)
+		return false;
+
+	struct epoll_event event;
+	event.events  = EPOLLIN;
+	event.data.fd = fd;
+
+	int ret = ::epoll_ctl(m_epollFD, EPOLL_CTL_ADD, fd, &event);
+	if (ret == -1 && errno != EEXIST) {
+		LogError("Cannot add fd %d to the epoll set, errno=%d", fd, errno);
+		return false;
+	}
+
+	return true;
+}
+
+void CReactor::removeFD(int fd)
+{
+	assert(m_epollFD != -1);
+
+	if (fd < 0)
+		return;
+
+	// A closed fd will already have been removed by the kernel
+	::epoll_ctl(m_epollFD, EPOLL_CTL_DEL, fd, NULL);
+}
+
+void CReactor::notify()
+{
+	if (m_eventFD == -1)
+		return;
+
+	uint64_t value = 1U;
+	ssize_t n = ::write(m_eventFD, &value, sizeof(uint64_t));
+	(void)n;
+}
+
+void CReactor::wait(int timeoutMS)
+{
+	assert(m_epollFD != -1);
+
+	struct epoll_event events[MAX_EVENTS];
+
+	int n = ::epoll_wait(m_epollFD, events, MAX_EVENTS, timeoutMS);
+	if (n == -1) {
+		if (errno != EINTR)
+			LogError("Error returned from epoll_wait, errno=%d", errno);
+		return;
+	}
+
+	for (int i = 0; i < n; i++) {
+		int fd = events[i].data.fd;
+		if (fd == m_eventFD || fd == m_timerFD)
+			drain(fd);
+	}
+}
+
+void CReactor::drain(int fd)
+{
+	uint64_t value;
+	ssize_t n = ::read(fd, &value, sizeof(uint64_t));
+	(void)n;
+}
+
+void CReactor::close()
+{
+	if (m_timerFD != -1) {
+		::close(m_timerFD);
+		m_timerFD = -1;
+	}
+
+	if (m_eventFD != -1) {
+		::close(m_eventFD);
+		m_eventFD = -1;
+	}
+
+	if (m_epollFD != -1) {
+		::close(m_epollFD);
+		m_epollFD = -1;
+	}
+}
@@ -0,0 +1,52 @@
+/*
+ *   Copyright (C) 2022 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#if !defined(REACTOR_H)
+#define	REACTOR_H
+
+// Wait for any of a set of file descriptors to become readable, for a
+// notification from another thread, or for a periodic tick, whichever
+// comes first.
+class CReactor {
+public:
+	CReactor(unsigned int tickMS);
+	~CReactor();
+
+	bool open();
+
+	bool addFD(int fd);
+	void removeFD(int fd);
+
+	// Safe to call from any thread
+	void notify();
+
+	// A negative timeout blocks until an event or the next tick
+	void wait(int timeoutMS = -1);
+
+	void close();
+
+private:
+	unsigned int m_tickMS;
+	int          m_epollFD;
+	int          m_eventFD;
+	int          m_timerFD;
+
+	void drain(int fd);
+};
+
+#endif
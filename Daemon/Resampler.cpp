@@ -0,0 +1,180 @@
+/*
+ *   Copyright (C) 2022 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include "Resampler.h"
+
+#include <cassert>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+static_assert(RESAMPLER_RATIO == 6U, "The resampler taps are designed for a ratio of 6");
+static_assert((RESAMPLER_PHASE_TAPS % 4U) == 0U, "The dot product works four taps at a time");
+
+// A Kaiser windowed sinc (beta 5.65) with its cutoff at 4kHz for a 48kHz
+// sample rate, normalised to unity gain at DC. It is symmetric.
+constexpr float TAPS[RESAMPLER_TAPS] = {
+	-2.349820887e-05F, -8.038021530e-05F, -1.345848587e-04F, -1.622328773e-04F, -1.412405928e-04F, -6.079781525e-05F,
+	7.082602300e-05F, 2.235897081e-04F, 3.504301586e-04F, 3.995575071e-04F, 3.316536854e-04F, 1.369605705e-04F,
+	-1.538294391e-04F, -4.701046897e-04F, -7.156411741e-04F, -7.947780734e-04F, -6.441140416e-04F, -2.602421711e-04F,
+	2.864843789e-04F, 8.594382466e-04F, 1.286098368e-03F, 1.405782086e-03F, 1.122555096e-03F, 4.473305525e-04F,
+	-4.861293695e-04F, -1.440875181e-03F, -2.131959852e-03F, -2.305813467e-03F, -1.823067307e-03F, -7.197512677e-04F,
+	7.753890419e-04F, 2.279558015e-03F, 3.347279495e-03F, 3.594591218e-03F, 2.823302811e-03F, 1.107844091e-03F,
+	-1.186768293e-03F, -3.470993134e-03F, -5.072924028e-03F, -5.424839085e-03F, -4.244986717e-03F, -1.660329003e-03F,
+	1.773779214e-03F, 5.176489558e-03F, 7.553153393e-03F, 8.068607460e-03F, 6.311013439e-03F, 2.468972861e-03F,
+	-2.640172776e-03F, -7.718223541e-03F, -1.129095957e-02F, -1.210409048e-02F, -9.510891989e-03F, -3.742323707e-03F,
+	4.030356821e-03F, 1.188453151e-02F, 1.756792300e-02F, 1.906984542e-02F, 1.520985917e-02F, 6.092642889e-03F,
+	-6.703623546e-03F, -2.028372619e-02F, -3.093604183e-02F, -3.489121316e-02F, -2.918218658e-02F, -1.241189062e-02F,
+	1.475738169e-02F, 4.952563764e-02F, 8.733280397e-02F, 1.226345110e-01F, 1.499249135e-01F, 1.647941312e-01F,
+	1.647941312e-01F, 1.499249135e-01F, 1.226345110e-01F, 8.733280397e-02F, 4.952563764e-02F, 1.475738169e-02F,
+	-1.241189062e-02F, -2.918218658e-02F, -3.489121316e-02F, -3.093604183e-02F, -2.028372619e-02F, -6.703623546e-03F,
+	6.092642889e-03F, 1.520985917e-02F, 1.906984542e-02F, 1.756792300e-02F, 1.188453151e-02F, 4.030356821e-03F,
+	-3.742323707e-03F, -9.510891989e-03F, -1.210409048e-02F, -1.129095957e-02F, -7.718223541e-03F, -2.640172776e-03F,
+	2.468972861e-03F, 6.311013439e-03F, 8.068607460e-03F, 7.553153393e-03F, 5.176489558e-03F, 1.773779214e-03F,
+	-1.660329003e-03F, -4.244986717e-03F, -5.424839085e-03F, -5.072924028e-03F, -3.470993134e-03F, -1.186768293e-03F,
+	1.107844091e-03F, 2.823302811e-03F, 3.594591218e-03F, 3.347279495e-03F, 2.279558015e-03F, 7.753890419e-04F,
+	-7.197512677e-04F, -1.823067307e-03F, -2.305813467e-03F, -2.131959852e-03F, -1.440875181e-03F, -4.861293695e-04F,
+	4.473305525e-04F, 1.122555096e-03F, 1.405782086e-03F, 1.286098368e-03F, 8.594382466e-04F, 2.864843789e-04F,
+	-2.602421711e-04F, -6.441140416e-04F, -7.947780734e-04F, -7.156411741e-04F, -4.701046897e-04F, -1.538294391e-04F,
+	1.369605705e-04F, 3.316536854e-04F, 3.995575071e-04F, 3.504301586e-04F, 2.235897081e-04F, 7.082602300e-05F,
+	-6.079781525e-05F, -1.412405928e-04F, -1.622328773e-04F, -1.345848587e-04F, -8.038021530e-05F, -2.349820887e-05F
+};
+
+// The interpolator's taps split into one filter per output phase, each
+// reversed so that it is a straight dot product with the input, and with
+// the gain of six lost to the zero stuffing put back.
+struct CResamplerPhases {
+	constexpr CResamplerPhases() :
+	m_taps()
+	{
+		for (unsigned int p = 0U; p < RESAMPLER_RATIO; p++) {
+			for (unsigned int j = 0U; j < RESAMPLER_PHASE_TAPS; j++)
+				m_taps[p][j] = float(RESAMPLER_RATIO) * TAPS[p + RESAMPLER_RATIO * (RESAMPLER_PHASE_TAPS - 1U - j)];
+		}
+	}
+
+	float m_taps[RESAMPLER_RATIO][RESAMPLER_PHASE_TAPS];
+};
+
+constexpr CResamplerPhases PHASES;
+
+// n must be a multiple of four
+static inline float dotProduct(const float* a, const float* b, unsigned int n)
+{
+#if defined(__SSE2__)
+	__m128 sum = _mm_setzero_ps();
+	for (unsigned int i = 0U; i < n; i += 4U)
+		sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+
+	__m128 shuf = _mm_shuffle_ps(sum, sum, _MM_SHUFFLE(2, 3, 0, 1));
+	sum  = _mm_add_ps(sum, shuf);
+	shuf = _mm_movehl_ps(shuf, sum);
+	sum  = _mm_add_ss(sum, shuf);
+
+	return _mm_cvtss_f32(sum);
+#elif defined(__ARM_NEON)
+	float32x4_t sum = vdupq_n_f32(0.0F);
+	for (unsigned int i = 0U; i < n; i += 4U)
+		sum = vmlaq_f32(sum, vld1q_f32(a + i), vld1q_f32(b + i));
+
+	float32x2_t half = vadd_f32(vget_low_f32(sum), vget_high_f32(sum));
+
+	return vget_lane_f32(vpadd_f32(half, half), 0);
+#else
+	float sum0 = 0.0F, sum1 = 0.0F, sum2 = 0.0F, sum3 = 0.0F;
+	for (unsigned int i = 0U; i < n; i += 4U) {
+		sum0 += a[i + 0U] * b[i + 0U];
+		sum1 += a[i + 1U] * b[i + 1U];
+		sum2 += a[i + 2U] * b[i + 2U];
+		sum3 += a[i + 3U] * b[i + 3U];
+	}
+
+	return (sum0 + sum1) + (sum2 + sum3);
+#endif
+}
+
+CResampler::CResampler() :
+m_interpolateBuffer(),
+m_decimateBuffer()
+{
+	reset();
+}
+
+CResampler::~CResampler()
+{
+}
+
+void CResampler::reset()
+{
+	::memset(m_interpolateBuffer, 0x00U, sizeof(m_interpolateBuffer));
+	::memset(m_decimateBuffer,    0x00U, sizeof(m_decimateBuffer));
+}
+
+void CResampler::interpolate(const float* in, unsigned int len, float* out)
+{
+	assert(in != NULL);
+	assert(out != NULL);
+
+	const unsigned int HISTORY = RESAMPLER_PHASE_TAPS - 1U;
+
+	while (len > 0U) {
+		unsigned int n = (len > CODEC_BLOCK_SIZE) ? CODEC_BLOCK_SIZE : len;
+
+		// The new input goes after the previous input that the filter still needs
+		::memcpy(m_interpolateBuffer + HISTORY, in, n * sizeof(float));
+
+		for (unsigned int i = 0U; i < n; i++) {
+			for (unsigned int p = 0U; p < RESAMPLER_RATIO; p++)
+				*out++ = dotProduct(PHASES.m_taps[p], m_interpolateBuffer + i, RESAMPLER_PHASE_TAPS);
+		}
+
+		::memmove(m_interpolateBuffer, m_interpolateBuffer + n, HISTORY * sizeof(float));
+
+		in  += n;
+		len -= n;
+	}
+}
+
+void CResampler::decimate(const float* in, unsigned int len, float* out)
+{
+	assert(in != NULL);
+	assert(out != NULL);
+	assert((len % RESAMPLER_RATIO) == 0U);
+
+	const unsigned int HISTORY = RESAMPLER_TAPS - 1U;
+
+	while (len > 0U) {
+		unsigned int n = (len > SOUNDCARD_BLOCK_SIZE) ? SOUNDCARD_BLOCK_SIZE : len;
+
+		::memcpy(m_decimateBuffer + HISTORY, in, n * sizeof(float));
+
+		// Only every sixth output of the filter is needed, and as the taps are
+		// symmetric they need no reversing
+		for (unsigned int i = 0U; i < n; i += RESAMPLER_RATIO)
+			*out++ = dotProduct(TAPS, m_decimateBuffer + i, RESAMPLER_TAPS);
+
+		::memmove(m_decimateBuffer, m_decimateBuffer + n, HISTORY * sizeof(float));
+
+		in  += n;
+		len -= n;
+	}
+}
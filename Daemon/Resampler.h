@@ -0,0 +1,51 @@
+/*
+ *   Copyright (C) 2022 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#if !defined(RESAMPLER_H)
+#define	RESAMPLER_H
+
+#include "Defines.h"
+
+const unsigned int RESAMPLER_RATIO      = SOUNDCARD_SAMPLE_RATE / CODEC_SAMPLE_RATE;
+const unsigned int RESAMPLER_TAPS       = 144U;
+const unsigned int RESAMPLER_PHASE_TAPS = RESAMPLER_TAPS / RESAMPLER_RATIO;
+
+// A fixed 6:1 polyphase FIR resampler between the codec and soundcard rates.
+// Both directions use the same 144 tap low pass filter, flat to 3.4kHz and
+// more than 55dB down from 4.6kHz, with a fixed delay of 71.5 soundcard
+// samples.
+class CResampler {
+public:
+	CResampler();
+	~CResampler();
+
+	// 8kHz to 48kHz, out must have room for len * 6 samples
+	void interpolate(const float* in, unsigned int len, float* out);
+
+	// 48kHz to 8kHz, len must be a multiple of 6 and out must have room for
+	// len / 6 samples
+	void decimate(const float* in, unsigned int len, float* out);
+
+	void reset();
+
+private:
+	float m_interpolateBuffer[RESAMPLER_PHASE_TAPS - 1U + CODEC_BLOCK_SIZE];
+	float m_decimateBuffer[RESAMPLER_TAPS - 1U + SOUNDCARD_BLOCK_SIZE];
+};
+
+#endif
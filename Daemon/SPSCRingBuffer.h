@@ -0,0 +1,176 @@
+/*
+ *   Copyright (C) 2006-2009,2012,2013,2015,2016,2022 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef SPSCRingBuffer_H
+#define SPSCRingBuffer_H
+
+#include "Log.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cassert>
+#include <cstring>
+#include <type_traits>
+
+const unsigned int SPSC_CACHE_LINE_SIZE = 64U;
+
+/*
+ * A ring buffer that is safe to share between exactly one producer thread
+ * and exactly one consumer thread without any locking. The producer owns
+ * the input pointer and the consumer owns the output pointer, each is
+ * published to the other side with release/acquire ordering.
+ *
+ * addData() may only be called by the producer, getData(), peek() and
+ * clear() may only be called by the consumer.
+ */
+template<class T> class CSPSCRingBuffer {
+	static_assert(std::is_trivially_copyable<T>::value, "CSPSCRingBuffer requires a trivially copyable type");
+
+public:
+	CSPSCRingBuffer(unsigned int length, const char* name) :
+	m_length(length + 1U),
+	m_name(name),
+	m_buffer(NULL),
+	m_iPtr(0U),
+	m_oPtr(0U)
+	{
+		assert(length > 0U);
+		assert(name != NULL);
+
+		m_buffer = new T[m_length];
+
+		::memset(m_buffer, 0x00, m_length * sizeof(T));
+	}
+
+	~CSPSCRingBuffer()
+	{
+		delete[] m_buffer;
+	}
+
+	bool addData(const T* buffer, unsigned int nSamples)
+	{
+		assert(buffer != NULL);
+
+		unsigned int space = freeSpace();
+		if (nSamples > space) {
+			LogError("%s buffer overflow, dropping the data. (%u > %u)", m_name, nSamples, space);
+			return false;
+		}
+
+		unsigned int iPtr = m_iPtr.load(std::memory_order_relaxed);
+
+		unsigned int first = m_length - iPtr;
+		if (first > nSamples)
+			first = nSamples;
+
+		::memcpy(m_buffer + iPtr, buffer, first * sizeof(T));
+		::memcpy(m_buffer, buffer + first, (nSamples - first) * sizeof(T));
+
+		iPtr += nSamples;
+		if (iPtr >= m_length)
+			iPtr -= m_length;
+
+		m_iPtr.store(iPtr, std::memory_order_release);
+
+		return true;
+	}
+
+	bool getData(T* buffer, unsigned int nSamples)
+	{
+		if (!peek(buffer, nSamples))
+			return false;
+
+		unsigned int oPtr = m_oPtr.load(std::memory_order_relaxed);
+
+		oPtr += nSamples;
+		if (oPtr >= m_length)
+			oPtr -= m_length;
+
+		m_oPtr.store(oPtr, std::memory_order_release);
+
+		return true;
+	}
+
+	bool peek(T* buffer, unsigned int nSamples) const
+	{
+		assert(buffer != NULL);
+
+		unsigned int size = dataSize();
+		if (size < nSamples) {
+			LogError("**** Underflow in %s ring buffer, %u < %u", m_name, size, nSamples);
+			return false;
+		}
+
+		unsigned int oPtr = m_oPtr.load(std::memory_order_relaxed);
+
+		unsigned int first = m_length - oPtr;
+		if (first > nSamples)
+			first = nSamples;
+
+		::memcpy(buffer, m_buffer + oPtr, first * sizeof(T));
+		::memcpy(buffer + first, m_buffer, (nSamples - first) * sizeof(T));
+
+		return true;
+	}
+
+	void clear()
+	{
+		m_oPtr.store(m_iPtr.load(std::memory_order_acquire), std::memory_order_release);
+	}
+
+	unsigned int freeSpace() const
+	{
+		return (m_length - 1U) - dataSize();
+	}
+
+	unsigned int dataSize() const
+	{
+		unsigned int iPtr = m_iPtr.load(std::memory_order_acquire);
+		unsigned int oPtr = m_oPtr.load(std::memory_order_acquire);
+
+		if (iPtr >= oPtr)
+			return iPtr - oPtr;
+		else
+			return m_length - (oPtr - iPtr);
+	}
+
+	bool hasSpace(unsigned int length) const
+	{
+		return freeSpace() > length;
+	}
+
+	bool hasData() const
+	{
+		return !isEmpty();
+	}
+
+	bool isEmpty() const
+	{
+		return m_oPtr.load(std::memory_order_acquire) == m_iPtr.load(std::memory_order_acquire);
+	}
+
+private:
+	unsigned int m_length;
+	const char*  m_name;
+	T*           m_buffer;
+
+	alignas(SPSC_CACHE_LINE_SIZE) std::atomic<unsigned int> m_iPtr;
+	alignas(SPSC_CACHE_LINE_SIZE) std::atomic<unsigned int> m_oPtr;
+};
+
+#endif
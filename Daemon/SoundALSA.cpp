@@ -22,11 +22,111 @@
 
 #include <cassert>
 
-CSoundALSA::CSoundALSA(const std::string& readDevice, const std::string& writeDevice, unsigned int sampleRate, unsigned int blockSize) :
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+// Reduce interleaved stereo to mono, in place
+static void deinterleave(float* samples, unsigned int frames, AUDIO_CHANNEL channel)
+{
+	unsigned int i = 0U;
+
+#if defined(__SSE2__)
+	const __m128 half = _mm_set1_ps(0.5F);
+
+	for (; (i + 4U) <= frames; i += 4U) {
+		__m128 a = _mm_loadu_ps(samples + 2U * i + 0U);
+		__m128 b = _mm_loadu_ps(samples + 2U * i + 4U);
+
+		__m128 left  = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+		__m128 right = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+
+		if (channel == AC_LEFT)
+			_mm_storeu_ps(samples + i, left);
+		else if (channel == AC_RIGHT)
+			_mm_storeu_ps(samples + i, right);
+		else
+			_mm_storeu_ps(samples + i, _mm_mul_ps(_mm_add_ps(left, right), half));
+	}
+#elif defined(__ARM_NEON)
+	for (; (i + 4U) <= frames; i += 4U) {
+		float32x4x2_t lr = vld2q_f32(samples + 2U * i);
+
+		if (channel == AC_LEFT)
+			vst1q_f32(samples + i, lr.val[0U]);
+		else if (channel == AC_RIGHT)
+			vst1q_f32(samples + i, lr.val[1U]);
+		else
+			vst1q_f32(samples + i, vmulq_n_f32(vaddq_f32(lr.val[0U], lr.val[1U]), 0.5F));
+	}
+#endif
+
+	for (; i < frames; i++) {
+		if (channel == AC_LEFT)
+			samples[i] = samples[2U * i + 0U];
+		else if (channel == AC_RIGHT)
+			samples[i] = samples[2U * i + 1U];
+		else
+			samples[i] = (samples[2U * i + 0U] + samples[2U * i + 1U]) * 0.5F;
+	}
+}
+
+// Expand mono to interleaved stereo, in place, working backwards so that
+// the mono audio is read before it is overwritten
+static void interleave(float* samples, unsigned int frames, AUDIO_CHANNEL channel)
+{
+	const float leftGain  = channel == AC_RIGHT ? 0.0F : 1.0F;
+	const float rightGain = channel == AC_LEFT  ? 0.0F : 1.0F;
+
+	unsigned int i = frames;
+
+	for (; (i % 4U) != 0U; i--) {
+		float sample = samples[i - 1U];
+		samples[2U * (i - 1U) + 0U] = sample * leftGain;
+		samples[2U * (i - 1U) + 1U] = sample * rightGain;
+	}
+
+#if defined(__SSE2__)
+	const __m128 left  = _mm_set1_ps(leftGain);
+	const __m128 right = _mm_set1_ps(rightGain);
+
+	for (; i > 0U; i -= 4U) {
+		__m128 mono = _mm_loadu_ps(samples + i - 4U);
+
+		__m128 l = _mm_mul_ps(mono, left);
+		__m128 r = _mm_mul_ps(mono, right);
+
+		_mm_storeu_ps(samples + 2U * (i - 4U) + 4U, _mm_unpackhi_ps(l, r));
+		_mm_storeu_ps(samples + 2U * (i - 4U) + 0U, _mm_unpacklo_ps(l, r));
+	}
+#elif defined(__ARM_NEON)
+	for (; i > 0U; i -= 4U) {
+		float32x4_t mono = vld1q_f32(samples + i - 4U);
+
+		float32x4x2_t lr;
+		lr.val[0U] = vmulq_n_f32(mono, leftGain);
+		lr.val[1U] = vmulq_n_f32(mono, rightGain);
+
+		vst2q_f32(samples + 2U * (i - 4U), lr);
+	}
+#else
+	for (; i > 0U; i--) {
+		float sample = samples[i - 1U];
+		samples[2U * (i - 1U) + 0U] = sample * leftGain;
+		samples[2U * (i - 1U) + 1U] = sample * rightGain;
+	}
+#endif
+}
+
+CSoundALSA::CSoundALSA(const std::string& readDevice, const std::string& writeDevice, unsigned int sampleRate, unsigned int blockSize, bool mmap, AUDIO_CHANNEL channel) :
 m_readDevice(readDevice),
 m_writeDevice(writeDevice),
 m_sampleRate(sampleRate),
 m_blockSize(blockSize),
+m_mmap(mmap),
+m_channel(channel),
 m_callback(NULL),
 m_id(-1),
 m_reader(NULL),
@@ -70,7 +170,13 @@ bool CSoundALSA::open()
 		return false;
 	}
 
-	if ((err = ::snd_pcm_hw_params_set_access(playHandle, hw_params, SND_PCM_ACCESS_RW_INTERLEAVED)) < 0) {
+	bool playMMAP = m_mmap;
+	if (playMMAP && (err = ::snd_pcm_hw_params_set_access(playHandle, hw_params, SND_PCM_ACCESS_MMAP_INTERLEAVED)) < 0) {
+		LogWarning("Cannot set mmap access for playback, using read/write (%s)", ::snd_strerror(err));
+		playMMAP = false;
+	}
+
+	if (!playMMAP && (err = ::snd_pcm_hw_params_set_access(playHandle, hw_params, SND_PCM_ACCESS_RW_INTERLEAVED)) < 0) {
 		LogError("Cannot set access type (%s)", ::snd_strerror(err));
 		return false;
 	}
@@ -82,6 +188,8 @@ bool CSoundALSA::open()
 
 	if ((err = ::snd_pcm_hw_params_set_rate(playHandle, hw_params, m_sampleRate, 0)) < 0) {
 		LogError("Cannot set sample rate (%s)", ::snd_strerror(err));
+		::snd_pcm_hw_params_free(hw_params);
+		::snd_pcm_close(playHandle);
 		return false;
 	}
 
@@ -125,7 +233,13 @@ bool CSoundALSA::open()
 		return false;
 	}
 
-	if ((err = ::snd_pcm_hw_params_set_access(recHandle, hw_params, SND_PCM_ACCESS_RW_INTERLEAVED)) < 0) {
+	bool recMMAP = m_mmap;
+	if (recMMAP && (err = ::snd_pcm_hw_params_set_access(recHandle, hw_params, SND_PCM_ACCESS_MMAP_INTERLEAVED)) < 0) {
+		LogWarning("Cannot set mmap access for capture, using read/write (%s)", ::snd_strerror(err));
+		recMMAP = false;
+	}
+
+	if (!recMMAP && (err = ::snd_pcm_hw_params_set_access(recHandle, hw_params, SND_PCM_ACCESS_RW_INTERLEAVED)) < 0) {
 		LogError("Cannot set access type (%s)", ::snd_strerror(err));
 		return false;
 	}
@@ -137,6 +251,9 @@ bool CSoundALSA::open()
 
 	if ((err = ::snd_pcm_hw_params_set_rate(recHandle, hw_params, m_sampleRate, 0)) < 0) {
 		LogError("Cannot set sample rate (%s)", ::snd_strerror(err));
+		::snd_pcm_hw_params_free(hw_params);
+		::snd_pcm_close(recHandle);
+		::snd_pcm_close(playHandle);
 		return false;
 	}
 
@@ -163,14 +280,20 @@ bool CSoundALSA::open()
 		return false;
 	}
 
-	short samples[256];
-	for (unsigned int i = 0U; i < 10U; ++i)
-		::snd_pcm_readi(recHandle, samples, 128);
+	// The mmap capture is started by the reader thread
+	if (!recMMAP) {
+		float samples[256];
+		for (unsigned int i = 0U; i < 10U; ++i)
+			::snd_pcm_readi(recHandle, samples, 128 / recChannels);
+	}
+
+	LogMessage("Opened %s:%s Rate %u%s", m_writeDevice.c_str(), m_readDevice.c_str(), m_sampleRate, (playMMAP && recMMAP) ? " MMAP" : "");
 
-	LogMessage("Opened %s:%s Rate %u", m_writeDevice.c_str(), m_readDevice.c_str(), m_sampleRate);
+	if (playChannels == 2U || recChannels == 2U)
+		LogMessage("Using the %s channel of the stereo device", m_channel == AC_LEFT ? "left" : (m_channel == AC_RIGHT ? "right" : "mixed"));
 
-	m_reader = new CSoundALSAReader(recHandle,  m_blockSize, recChannels,  m_callback, m_id);
-	m_writer = new CSoundALSAWriter(playHandle, m_blockSize, playChannels, m_callback, m_id);
+	m_reader = new CSoundALSAReader(recHandle,  m_blockSize, recChannels,  m_channel, recMMAP,  m_callback, m_id);
+	m_writer = new CSoundALSAWriter(playHandle, m_blockSize, playChannels, m_channel, playMMAP, m_callback, m_id);
 
 	m_reader->run();
 	m_writer->run();
@@ -192,13 +315,15 @@ bool CSoundALSA::isWriterBusy() const
 	return m_writer->isBusy();
 }
 
-CSoundALSAReader::CSoundALSAReader(snd_pcm_t* handle, unsigned int blockSize, unsigned int channels, IAudioCallback* callback, int id) :
-CThread(),
+CSoundALSAReader::CSoundALSAReader(snd_pcm_t* handle, unsigned int blockSize, unsigned int channels, AUDIO_CHANNEL channel, bool mmap, IAudioCallback* callback, int id) :
+CThread("Audio Capture"),
 m_handle(handle),
 m_blockSize(blockSize),
 m_channels(channels),
+m_channel(channel),
 m_callback(callback),
 m_id(id),
+m_mmap(mmap),
 m_killed(false),
 m_samples(NULL)
 {
@@ -207,7 +332,8 @@ m_samples(NULL)
 	assert(channels == 1U || channels == 2U);
 	assert(callback != NULL);
 
-	m_samples = new float[4U * blockSize];
+	if (!mmap)
+		m_samples = new float[4U * blockSize];
 }
 
 CSoundALSAReader::~CSoundALSAReader()
@@ -220,18 +346,10 @@ void CSoundALSAReader::entry()
 	LogMessage("Starting ALSA reader thread");
 
 	while (!m_killed) {
-		snd_pcm_sframes_t ret;
-		while ((ret = ::snd_pcm_readi(m_handle, m_samples, m_blockSize)) < 0) {
-			if (ret != -EPIPE)
-				LogWarning("snd_pcm_readi returned %d (%s)", ret, ::snd_strerror(ret));
-
-			::snd_pcm_recover(m_handle, ret, 1);
-		}
-
-		if (ret > 0)
-			m_callback->readCallback(m_samples, (unsigned int)ret, m_id);
+		if (m_mmap)
+			readMMAP();
 		else
-			sleep(5UL);
+			readRW();
 	}
 
 	LogMessage("Stopping ALSA reader thread");
@@ -239,18 +357,90 @@ void CSoundALSAReader::entry()
 	::snd_pcm_close(m_handle);
 }
 
+void CSoundALSAReader::readRW()
+{
+	snd_pcm_sframes_t ret;
+	while ((ret = ::snd_pcm_readi(m_handle, m_samples, m_blockSize)) < 0) {
+		if (ret != -EPIPE)
+			LogWarning("snd_pcm_readi returned %d (%s)", ret, ::snd_strerror(ret));
+
+		::snd_pcm_recover(m_handle, ret, 1);
+	}
+
+	if (ret > 0) {
+		if (m_channels == 2U)
+			deinterleave(m_samples, (unsigned int)ret, m_channel);
+
+		m_callback->readCallback(m_samples, (unsigned int)ret, m_id);
+	} else {
+		sleep(5UL);
+	}
+}
+
+void CSoundALSAReader::readMMAP()
+{
+	// An mmap capture does not start itself, including after an overrun
+	if (::snd_pcm_state(m_handle) == SND_PCM_STATE_PREPARED)
+		::snd_pcm_start(m_handle);
+
+	snd_pcm_sframes_t avail = ::snd_pcm_avail_update(m_handle);
+	if (avail < 0) {
+		if (avail != -EPIPE)
+			LogWarning("snd_pcm_avail_update returned %d (%s)", avail, ::snd_strerror(avail));
+
+		::snd_pcm_recover(m_handle, avail, 1);
+		return;
+	}
+
+	// Wait on the poll descriptors for a full block
+	if (snd_pcm_uframes_t(avail) < m_blockSize) {
+		int ret = ::snd_pcm_wait(m_handle, 100);
+		if (ret < 0)
+			::snd_pcm_recover(m_handle, ret, 1);
+		return;
+	}
+
+	const snd_pcm_channel_area_t* areas = NULL;
+	snd_pcm_uframes_t offset = 0U;
+	snd_pcm_uframes_t frames = m_blockSize;
+
+	int err = ::snd_pcm_mmap_begin(m_handle, &areas, &offset, &frames);
+	if (err < 0) {
+		LogWarning("snd_pcm_mmap_begin returned %d (%s)", err, ::snd_strerror(err));
+		::snd_pcm_recover(m_handle, err, 1);
+		return;
+	}
+
+	float* samples = (float*)((unsigned char*)areas[0U].addr + (areas[0U].first + offset * areas[0U].step) / 8U);
+
+	if (m_channels == 2U)
+		deinterleave(samples, (unsigned int)frames, m_channel);
+
+	m_callback->readCallback(samples, (unsigned int)frames, m_id);
+
+	snd_pcm_sframes_t ret = ::snd_pcm_mmap_commit(m_handle, offset, frames);
+	if (ret < 0 || snd_pcm_uframes_t(ret) != frames) {
+		if (ret != -EPIPE)
+			LogWarning("snd_pcm_mmap_commit returned %d (%s)", ret, ::snd_strerror(ret < 0 ? ret : -EPIPE));
+
+		::snd_pcm_recover(m_handle, ret < 0 ? ret : -EPIPE, 1);
+	}
+}
+
 void CSoundALSAReader::kill()
 {
 	m_killed = true;
 }
 
-CSoundALSAWriter::CSoundALSAWriter(snd_pcm_t* handle, unsigned int blockSize, unsigned int channels, IAudioCallback* callback, int id) :
-CThread(),
+CSoundALSAWriter::CSoundALSAWriter(snd_pcm_t* handle, unsigned int blockSize, unsigned int channels, AUDIO_CHANNEL channel, bool mmap, IAudioCallback* callback, int id) :
+CThread("Audio Playback"),
 m_handle(handle),
 m_blockSize(blockSize),
 m_channels(channels),
+m_channel(channel),
 m_callback(callback),
 m_id(id),
+m_mmap(mmap),
 m_killed(false),
 m_samples(NULL)
 {
@@ -259,7 +449,8 @@ m_samples(NULL)
 	assert(channels == 1U || channels == 2U);
 	assert(callback != NULL);
 
-	m_samples = new float[4U * blockSize];
+	if (!mmap)
+		m_samples = new float[4U * blockSize];
 }
 
 CSoundALSAWriter::~CSoundALSAWriter()
@@ -272,25 +463,10 @@ void CSoundALSAWriter::entry()
 	LogMessage("Starting ALSA writer thread");
 
 	while (!m_killed) {
-		int nSamples = 2 * m_blockSize;
-		m_callback->writeCallback(m_samples, nSamples, m_id);
-
-		if (nSamples == 0) {
-			sleep(5UL);
-		} else {
-			int offset = 0;
-			snd_pcm_sframes_t ret;
-			while ((ret = ::snd_pcm_writei(m_handle, m_samples + offset, nSamples - offset)) != (nSamples - offset)) {
-				if (ret < 0) {
-					if (ret != -EPIPE)
-						LogWarning("snd_pcm_writei returned %d (%s)", ret, ::snd_strerror(ret));
-
-					::snd_pcm_recover(m_handle, ret, 1);
-				} else {
-					offset += ret;
-				}
-			}
-		}
+		if (m_mmap)
+			writeMMAP();
+		else
+			writeRW();
 	}
 
 	LogMessage("Stopping ALSA writer thread");
@@ -298,6 +474,86 @@ void CSoundALSAWriter::entry()
 	::snd_pcm_close(m_handle);
 }
 
+void CSoundALSAWriter::writeRW()
+{
+	int nSamples = 2 * m_blockSize;
+	m_callback->writeCallback(m_samples, nSamples, m_id);
+
+	if (nSamples == 0) {
+		sleep(5UL);
+	} else {
+		if (m_channels == 2U)
+			interleave(m_samples, (unsigned int)nSamples, m_channel);
+
+		int offset = 0;
+		snd_pcm_sframes_t ret;
+		while ((ret = ::snd_pcm_writei(m_handle, m_samples + offset * m_channels, nSamples - offset)) != (nSamples - offset)) {
+			if (ret < 0) {
+				if (ret != -EPIPE)
+					LogWarning("snd_pcm_writei returned %d (%s)", ret, ::snd_strerror(ret));
+
+				::snd_pcm_recover(m_handle, ret, 1);
+			} else {
+				offset += ret;
+			}
+		}
+	}
+}
+
+void CSoundALSAWriter::writeMMAP()
+{
+	snd_pcm_sframes_t avail = ::snd_pcm_avail_update(m_handle);
+	if (avail < 0) {
+		if (avail != -EPIPE)
+			LogWarning("snd_pcm_avail_update returned %d (%s)", avail, ::snd_strerror(avail));
+
+		::snd_pcm_recover(m_handle, avail, 1);
+		return;
+	}
+
+	// Wait on the poll descriptors for room for a full block
+	if (snd_pcm_uframes_t(avail) < m_blockSize) {
+		int ret = ::snd_pcm_wait(m_handle, 100);
+		if (ret < 0)
+			::snd_pcm_recover(m_handle, ret, 1);
+		return;
+	}
+
+	const snd_pcm_channel_area_t* areas = NULL;
+	snd_pcm_uframes_t offset = 0U;
+	snd_pcm_uframes_t frames = 2U * m_blockSize;
+
+	int err = ::snd_pcm_mmap_begin(m_handle, &areas, &offset, &frames);
+	if (err < 0) {
+		LogWarning("snd_pcm_mmap_begin returned %d (%s)", err, ::snd_strerror(err));
+		::snd_pcm_recover(m_handle, err, 1);
+		return;
+	}
+
+	float* samples = (float*)((unsigned char*)areas[0U].addr + (areas[0U].first + offset * areas[0U].step) / 8U);
+
+	int nSamples = int(frames);
+	m_callback->writeCallback(samples, nSamples, m_id);
+
+	if (m_channels == 2U)
+		interleave(samples, (unsigned int)nSamples, m_channel);
+
+	snd_pcm_sframes_t ret = ::snd_pcm_mmap_commit(m_handle, offset, snd_pcm_uframes_t(nSamples));
+	if (ret < 0 || ret != nSamples) {
+		if (ret != -EPIPE)
+			LogWarning("snd_pcm_mmap_commit returned %d (%s)", ret, ::snd_strerror(ret < 0 ? ret : -EPIPE));
+
+		::snd_pcm_recover(m_handle, ret < 0 ? ret : -EPIPE, 1);
+	} else if (nSamples > 0 && ::snd_pcm_state(m_handle) == SND_PCM_STATE_PREPARED) {
+		// An mmap playback does not start itself either, including after an
+		// underrun, so start it once there is audio queued
+		::snd_pcm_start(m_handle);
+	}
+
+	if (nSamples == 0)
+		sleep(5UL);
+}
+
 void CSoundALSAWriter::kill()
 {
 	m_killed = true;
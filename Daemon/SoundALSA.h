@@ -17,6 +17,7 @@
 
 #include "AudioBackend.h"
 #include "AudioCallback.h"
+#include "Defines.h"
 #include "Thread.h"
 
 #include <vector>
@@ -26,7 +27,7 @@
 
 class CSoundALSAReader : public CThread {
 public:
-	CSoundALSAReader(snd_pcm_t* handle, unsigned int blockSize, unsigned int channels, IAudioCallback* callback, int id);
+	CSoundALSAReader(snd_pcm_t* handle, unsigned int blockSize, unsigned int channels, AUDIO_CHANNEL channel, bool mmap, IAudioCallback* callback, int id);
 	virtual ~CSoundALSAReader();
 
 	virtual void entry();
@@ -37,15 +38,20 @@ private:
 	snd_pcm_t*      m_handle;
 	unsigned int    m_blockSize;
 	unsigned int    m_channels;
+	AUDIO_CHANNEL   m_channel;
 	IAudioCallback* m_callback;
 	int             m_id;
+	bool            m_mmap;
 	bool            m_killed;
 	float*          m_samples;
+
+	void readRW();
+	void readMMAP();
 };
 
 class CSoundALSAWriter : public CThread {
 public:
-	CSoundALSAWriter(snd_pcm_t* handle, unsigned int blockSize, unsigned int channels, IAudioCallback* callback, int id);
+	CSoundALSAWriter(snd_pcm_t* handle, unsigned int blockSize, unsigned int channels, AUDIO_CHANNEL channel, bool mmap, IAudioCallback* callback, int id);
 	virtual ~CSoundALSAWriter();
 
 	virtual void entry();
@@ -58,15 +64,20 @@ private:
 	snd_pcm_t*      m_handle;
 	unsigned int    m_blockSize;
 	unsigned int    m_channels;
+	AUDIO_CHANNEL   m_channel;
 	IAudioCallback* m_callback;
 	int             m_id;
+	bool            m_mmap;
 	bool            m_killed;
 	float*          m_samples;
+
+	void writeRW();
+	void writeMMAP();
 };
 
 class CSoundALSA : public IAudioBackend {
 public:
-	CSoundALSA(const std::string& readDevice, const std::string& writeDevice, unsigned int sampleRate, unsigned int blockSize);
+	CSoundALSA(const std::string& readDevice, const std::string& writeDevice, unsigned int sampleRate, unsigned int blockSize, bool mmap = false, AUDIO_CHANNEL channel = AC_MIX);
 	~CSoundALSA();
 
 	void setCallback(IAudioCallback* callback, int id = 0);
@@ -80,6 +91,8 @@ private:
 	std::string       m_writeDevice;
 	unsigned int      m_sampleRate;
 	unsigned int      m_blockSize;
+	bool              m_mmap;
+	AUDIO_CHANNEL     m_channel;
 	IAudioCallback*   m_callback;
 	int               m_id;
 	CSoundALSAReader* m_reader;
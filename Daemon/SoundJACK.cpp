@@ -0,0 +1,309 @@
+/*
+ *   Copyright (C) 2022 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include "SoundJACK.h"
+#include "Log.h"
+
+#include <cassert>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+
+#include <sys/eventfd.h>
+#include <poll.h>
+#include <unistd.h>
+
+CSoundJACK::CSoundJACK(const std::string& readDevice, const std::string& writeDevice, unsigned int sampleRate, unsigned int blockSize, unsigned int quantum) :
+m_readDevice(readDevice),
+m_writeDevice(writeDevice),
+m_sampleRate(sampleRate),
+m_blockSize(blockSize),
+m_quantum(quantum),
+m_callback(NULL),
+m_id(-1),
+m_client(NULL),
+m_inPort(NULL),
+m_outPort(NULL),
+m_eventFD(-1),
+m_capture(4U * blockSize, "JACK Capture"),
+m_playback(4U * blockSize, "JACK Playback"),
+m_busy(false),
+m_worker(NULL)
+{
+	assert(sampleRate > 0U);
+	assert(blockSize > 0U);
+}
+
+CSoundJACK::~CSoundJACK()
+{
+}
+
+void CSoundJACK::setCallback(IAudioCallback* callback, int id)
+{
+	assert(callback != NULL);
+
+	m_callback = callback;
+
+	m_id = id;
+}
+
+bool CSoundJACK::open()
+{
+	jack_status_t status;
+	m_client = ::jack_client_open("M17Client", JackNoStartServer, &status);
+	if (m_client == NULL) {
+		LogError("Cannot connect to the JACK server, status=0x%02X", (unsigned int)status);
+		return false;
+	}
+
+	// JACK runs every client at the server's rate
+	jack_nframes_t sampleRate = ::jack_get_sample_rate(m_client);
+	if (sampleRate != m_sampleRate) {
+		LogError("The JACK server is running at %u Hz, not %u Hz", sampleRate, m_sampleRate);
+		cleanup();
+		return false;
+	}
+
+	if (m_quantum > 0U && ::jack_get_buffer_size(m_client) != m_quantum) {
+		int err = ::jack_set_buffer_size(m_client, m_quantum);
+		if (err != 0)
+			LogWarning("Cannot set the JACK buffer size to %u frames, error=%d", m_quantum, err);
+	}
+
+	unsigned int quantum = ::jack_get_buffer_size(m_client);
+	if (quantum > m_blockSize) {
+		LogError("The JACK buffer size of %u frames is larger than %u frames", quantum, m_blockSize);
+		cleanup();
+		return false;
+	}
+
+	m_inPort  = ::jack_port_register(m_client, "input",  JACK_DEFAULT_AUDIO_TYPE, JackPortIsInput,  0UL);
+	m_outPort = ::jack_port_register(m_client, "output", JACK_DEFAULT_AUDIO_TYPE, JackPortIsOutput, 0UL);
+	if (m_inPort == NULL || m_outPort == NULL) {
+		LogError("Cannot register the JACK ports");
+		cleanup();
+		return false;
+	}
+
+	m_eventFD = ::eventfd(0U, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (m_eventFD == -1) {
+		LogError("Cannot create the eventfd, errno=%d", errno);
+		cleanup();
+		return false;
+	}
+
+	::jack_set_process_callback(m_client, process, this);
+	::jack_on_shutdown(m_client, shutdown, this);
+
+	m_worker = new CSoundJACKWorker(m_capture, m_playback, m_eventFD, m_blockSize, quantum, m_callback, m_id);
+	m_worker->run();
+
+	int err = ::jack_activate(m_client);
+	if (err != 0) {
+		LogError("Cannot activate the JACK client, error=%d", err);
+		cleanup();
+		return false;
+	}
+
+	if (!connect(m_readDevice, true) || !connect(m_writeDevice, false)) {
+		cleanup();
+		return false;
+	}
+
+	LogMessage("Opened JACK %s:%s Rate %u Buffer %u", m_writeDevice.c_str(), m_readDevice.c_str(), m_sampleRate, quantum);
+
+	return true;
+}
+
+bool CSoundJACK::connect(const std::string& device, bool capture)
+{
+	const char* port = capture ? ::jack_port_name(m_inPort) : ::jack_port_name(m_outPort);
+
+	// Connect to the first physical port, or to the named one
+	if (device.empty() || device == "default") {
+		const char** ports = ::jack_get_ports(m_client, NULL, JACK_DEFAULT_AUDIO_TYPE, JackPortIsPhysical | (capture ? JackPortIsOutput : JackPortIsInput));
+		if (ports == NULL || ports[0U] == NULL) {
+			LogError("No physical JACK %s ports are available", capture ? "capture" : "playback");
+			::jack_free(ports);
+			return false;
+		}
+
+		int err = capture ? ::jack_connect(m_client, ports[0U], port) : ::jack_connect(m_client, port, ports[0U]);
+		if (err != 0)
+			LogError("Cannot connect the JACK port %s, error=%d", ports[0U], err);
+
+		::jack_free(ports);
+
+		return err == 0;
+	}
+
+	int err = capture ? ::jack_connect(m_client, device.c_str(), port) : ::jack_connect(m_client, port, device.c_str());
+	if (err != 0) {
+		LogError("Cannot connect the JACK port %s, error=%d", device.c_str(), err);
+		return false;
+	}
+
+	return true;
+}
+
+void CSoundJACK::close()
+{
+	cleanup();
+}
+
+void CSoundJACK::cleanup()
+{
+	if (m_client != NULL)
+		::jack_deactivate(m_client);
+
+	if (m_worker != NULL) {
+		m_worker->kill();
+		m_worker->wait();
+		delete m_worker;
+		m_worker = NULL;
+	}
+
+	if (m_client != NULL) {
+		::jack_client_close(m_client);
+		m_client = NULL;
+	}
+
+	if (m_eventFD != -1) {
+		::close(m_eventFD);
+		m_eventFD = -1;
+	}
+
+	m_inPort  = NULL;
+	m_outPort = NULL;
+}
+
+bool CSoundJACK::isWriterBusy() const
+{
+	return m_busy.load(std::memory_order_relaxed) || m_playback.hasData();
+}
+
+// Called on the JACK real time thread, it only touches the lock free queues
+// and the eventfd
+int CSoundJACK::process(jack_nframes_t nFrames, void* arg)
+{
+	assert(arg != NULL);
+
+	CSoundJACK* sound = static_cast<CSoundJACK*>(arg);
+
+	const float* in = static_cast<const float*>(::jack_port_get_buffer(sound->m_inPort, nFrames));
+	float* out      = static_cast<float*>(::jack_port_get_buffer(sound->m_outPort, nFrames));
+
+	// Drop the capture if the worker has fallen behind
+	if (sound->m_capture.freeSpace() >= nFrames)
+		sound->m_capture.addData(in, nFrames);
+
+	unsigned int n = sound->m_playback.dataSize();
+	if (n > nFrames)
+		n = nFrames;
+
+	if (n > 0U)
+		sound->m_playback.getData(out, n);
+
+	::memset(out + n, 0x00, (nFrames - n) * sizeof(float));
+
+	sound->m_busy.store(n > 0U, std::memory_order_relaxed);
+
+	uint64_t value = 1U;
+	ssize_t ret = ::write(sound->m_eventFD, &value, sizeof(uint64_t));
+	(void)ret;
+
+	return 0;
+}
+
+void CSoundJACK::shutdown(void* arg)
+{
+	LogError("The JACK server has shut down");
+}
+
+CSoundJACKWorker::CSoundJACKWorker(CSPSCRingBuffer<float>& capture, CSPSCRingBuffer<float>& playback, int eventFD, unsigned int blockSize, unsigned int quantum, IAudioCallback* callback, int id) :
+CThread("Audio JACK"),
+m_capture(capture),
+m_playback(playback),
+m_eventFD(eventFD),
+m_blockSize(blockSize),
+m_quantum(quantum),
+m_callback(callback),
+m_id(id),
+m_killed(false),
+m_samples(NULL)
+{
+	assert(eventFD != -1);
+	assert(blockSize > 0U);
+	assert(quantum > 0U);
+	assert(callback != NULL);
+
+	m_samples = new float[blockSize];
+}
+
+CSoundJACKWorker::~CSoundJACKWorker()
+{
+	delete[] m_samples;
+}
+
+void CSoundJACKWorker::entry()
+{
+	LogMessage("Starting JACK worker thread");
+
+	while (!m_killed) {
+		// Woken once per JACK cycle
+		struct pollfd pfd;
+		pfd.fd      = m_eventFD;
+		pfd.events  = POLLIN;
+		pfd.revents = 0;
+
+		if (::poll(&pfd, 1, 100) > 0) {
+			uint64_t value;
+			ssize_t ret = ::read(m_eventFD, &value, sizeof(uint64_t));
+			(void)ret;
+		}
+
+		unsigned int n;
+		while ((n = m_capture.dataSize()) > 0U) {
+			if (n > m_blockSize)
+				n = m_blockSize;
+
+			m_capture.getData(m_samples, n);
+			m_callback->readCallback(m_samples, n, m_id);
+		}
+
+		// Keep two JACK cycles of audio queued for playback
+		while (m_playback.dataSize() < (2U * m_quantum)) {
+			int nSamples = int(m_playback.freeSpace());
+			if (nSamples > int(m_blockSize))
+				nSamples = int(m_blockSize);
+
+			m_callback->writeCallback(m_samples, nSamples, m_id);
+			if (nSamples == 0)
+				break;
+
+			m_playback.addData(m_samples, nSamples);
+		}
+	}
+
+	LogMessage("Stopping JACK worker thread");
+}
+
+void CSoundJACKWorker::kill()
+{
+	m_killed = true;
+}
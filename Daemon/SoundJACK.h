@@ -0,0 +1,90 @@
+/*
+ *   Copyright (C) 2022 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef	SoundJACK_H
+#define	SoundJACK_H
+
+#include "SPSCRingBuffer.h"
+#include "AudioBackend.h"
+#include "AudioCallback.h"
+#include "Thread.h"
+
+#include <atomic>
+#include <string>
+
+#include <jack/jack.h>
+
+// Moves audio between the JACK queues and the audio callback, so that the
+// JACK process callback never calls into the rest of the daemon
+class CSoundJACKWorker : public CThread {
+public:
+	CSoundJACKWorker(CSPSCRingBuffer<float>& capture, CSPSCRingBuffer<float>& playback, int eventFD, unsigned int blockSize, unsigned int quantum, IAudioCallback* callback, int id);
+	virtual ~CSoundJACKWorker();
+
+	virtual void entry();
+
+	virtual void kill();
+
+private:
+	CSPSCRingBuffer<float>& m_capture;
+	CSPSCRingBuffer<float>& m_playback;
+	int                     m_eventFD;
+	unsigned int            m_blockSize;
+	unsigned int            m_quantum;
+	IAudioCallback*         m_callback;
+	int                     m_id;
+	bool                    m_killed;
+	float*                  m_samples;
+};
+
+class CSoundJACK : public IAudioBackend {
+public:
+	CSoundJACK(const std::string& readDevice, const std::string& writeDevice, unsigned int sampleRate, unsigned int blockSize, unsigned int quantum);
+	~CSoundJACK();
+
+	void setCallback(IAudioCallback* callback, int id = 0);
+	bool open();
+	void close();
+
+	bool isWriterBusy() const;
+
+private:
+	std::string            m_readDevice;
+	std::string            m_writeDevice;
+	unsigned int           m_sampleRate;
+	unsigned int           m_blockSize;
+	unsigned int           m_quantum;
+	IAudioCallback*        m_callback;
+	int                    m_id;
+	jack_client_t*         m_client;
+	jack_port_t*           m_inPort;
+	jack_port_t*           m_outPort;
+	int                    m_eventFD;
+	CSPSCRingBuffer<float> m_capture;
+	CSPSCRingBuffer<float> m_playback;
+	std::atomic<bool>      m_busy;
+	CSoundJACKWorker*      m_worker;
+
+	bool connect(const std::string& device, bool capture);
+	void cleanup();
+
+	static int process(jack_nframes_t nFrames, void* arg);
+	static void shutdown(void* arg);
+};
+
+#endif
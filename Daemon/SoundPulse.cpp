@@ -65,6 +65,7 @@ bool CSoundPulse::open()
 	pa_simple* recHandle = ::pa_simple_new(NULL, "M17Client", PA_STREAM_RECORD, m_readDevice.c_str(), "Transmit", &ss, NULL, NULL, NULL);
 	if (!recHandle) {
 		LogError("Cannot open capture audio device %s", m_readDevice.c_str());
+		::pa_simple_free(playHandle);
 		return false;
 	}
 
@@ -94,7 +95,7 @@ bool CSoundPulse::isWriterBusy() const
 }
 
 CSoundPulseReader::CSoundPulseReader(pa_simple* handle, unsigned int blockSize, unsigned int channels, IAudioCallback* callback, int id) :
-CThread(),
+CThread("Audio Capture"),
 m_handle(handle),
 m_blockSize(blockSize),
 m_channels(channels),
@@ -141,7 +142,7 @@ void CSoundPulseReader::kill()
 }
 
 CSoundPulseWriter::CSoundPulseWriter(pa_simple* handle, unsigned int blockSize, unsigned int channels, IAudioCallback* callback, int id) :
-CThread(),
+CThread("Audio Playback"),
 m_handle(handle),
 m_blockSize(blockSize),
 m_channels(channels),
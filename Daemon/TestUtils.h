@@ -0,0 +1,53 @@
+/*
+ *   Copyright (C) 2022 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#if !defined(TestUtils_H)
+#define	TestUtils_H
+
+#include <cstdio>
+#include <cstdlib>
+
+// The common parts of the test programs run by "make check". The random
+// data is repeatable, the first argument changes the seed.
+class CTestUtils {
+public:
+	static void seed(int argc, char** argv)
+	{
+		::srand(argc > 1 ? ::atoi(argv[1]) : 1);
+	}
+
+	static void randomBytes(unsigned char* data, unsigned int len)
+	{
+		for (unsigned int i = 0U; i < len; i++)
+			data[i] = ::rand() & 0xFFU;
+	}
+
+	static float randomFloat(float min, float max)
+	{
+		return min + (max - min) * float(::rand()) / float(RAND_MAX);
+	}
+
+	static bool report(const char* name, unsigned int runs, unsigned int failures)
+	{
+		::fprintf(stdout, "%s: %u runs, %u failures\n", name, runs, failures);
+
+		return failures == 0U;
+	}
+};
+
+#endif
@@ -17,11 +17,24 @@
  */
 
 #include "Thread.h"
+#include "Log.h"
 
+#include <sched.h>
 #include <unistd.h>
 
-CThread::CThread() :
-m_thread()
+struct CThreadScheduling {
+	std::string               m_prefix;
+	int                       m_policy;
+	int                       m_priority;
+	std::vector<unsigned int> m_cpus;
+};
+
+// Only written before the threads are started
+static std::vector<CThreadScheduling> scheduling;
+
+CThread::CThread(const std::string& name) :
+m_thread(),
+m_name(name)
 {
 }
 
@@ -45,6 +58,9 @@ void* CThread::helper(void* arg)
 {
 	CThread* p = (CThread*)arg;
 
+	if (!p->m_name.empty())
+		setCurrent(p->m_name);
+
 	p->entry();
 
 	return NULL;
@@ -60,3 +76,47 @@ void CThread::sleep(unsigned int ms)
 	::nanosleep(&ts, NULL);
 }
 
+void CThread::setScheduling(const std::string& prefix, int policy, int priority, const std::vector<unsigned int>& cpus)
+{
+	CThreadScheduling entry;
+	entry.m_prefix   = prefix;
+	entry.m_policy   = policy;
+	entry.m_priority = priority;
+	entry.m_cpus     = cpus;
+
+	scheduling.push_back(entry);
+}
+
+void CThread::setCurrent(const std::string& name)
+{
+	// Linux limits thread names to 15 characters
+	::pthread_setname_np(::pthread_self(), name.substr(0U, 15U).c_str());
+
+	for (std::vector<CThreadScheduling>::const_iterator it = scheduling.cbegin(); it != scheduling.cend(); ++it) {
+		if (name.compare(0U, it->m_prefix.size(), it->m_prefix) != 0)
+			continue;
+
+		if (it->m_policy != SCHED_OTHER) {
+			struct sched_param param;
+			param.sched_priority = it->m_priority;
+
+			int ret = ::pthread_setschedparam(::pthread_self(), it->m_policy, &param);
+			if (ret != 0)
+				LogWarning("Unable to set the scheduling of the %s thread, error=%d", name.c_str(), ret);
+		}
+
+		if (!it->m_cpus.empty()) {
+			cpu_set_t cpus;
+			CPU_ZERO(&cpus);
+
+			for (std::vector<unsigned int>::const_iterator it2 = it->m_cpus.cbegin(); it2 != it->m_cpus.cend(); ++it2)
+				CPU_SET(*it2, &cpus);
+
+			int ret = ::pthread_setaffinity_np(::pthread_self(), sizeof(cpu_set_t), &cpus);
+			if (ret != 0)
+				LogWarning("Unable to set the CPU affinity of the %s thread, error=%d", name.c_str(), ret);
+		}
+
+		return;
+	}
+}
@@ -21,10 +21,13 @@
 
 #include <pthread.h>
 
+#include <string>
+#include <vector>
+
 class CThread
 {
 public:
-  CThread();
+  CThread(const std::string& name = "");
   virtual ~CThread();
 
   virtual bool run();
@@ -35,8 +38,16 @@ public:
 
   static void sleep(unsigned int ms);
 
+  // Set the policy, priority and CPUs for every thread whose name starts
+  // with prefix. It must be called before those threads are started.
+  static void setScheduling(const std::string& prefix, int policy, int priority, const std::vector<unsigned int>& cpus);
+
+  // Name the calling thread and apply any scheduling set for that name
+  static void setCurrent(const std::string& name);
+
 private:
-  pthread_t m_thread;
+  pthread_t   m_thread;
+  std::string m_name;
 
   static void* helper(void* arg);
 };
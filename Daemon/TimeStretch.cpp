@@ -0,0 +1,104 @@
+/*
+ *   Copyright (C) 2022 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include "TimeStretch.h"
+
+#include <cassert>
+#include <cstring>
+#include <cmath>
+
+const float TS_MATCH_TOLERANCE = 0.005F;
+
+unsigned int CTimeStretch::stretch(const float* in, unsigned int len, float* out)
+{
+	assert(in != NULL);
+	assert(out != NULL);
+	assert(len >= TS_MIN_LENGTH);
+
+	// Repeat one period ending at TS_MAX_PERIOD, the window after the
+	// splice point is matched against the window one period earlier
+	const float* splice = in + TS_MAX_PERIOD;
+	unsigned int period = findPeriod(splice, splice, false);
+
+	::memcpy(out, in, TS_MAX_PERIOD * sizeof(float));
+	crossFade(splice, splice - period, out + TS_MAX_PERIOD);
+	::memcpy(out + TS_MAX_PERIOD + TS_WINDOW, splice - period + TS_WINDOW, (len - TS_MAX_PERIOD - TS_WINDOW + period) * sizeof(float));
+
+	return len + period;
+}
+
+unsigned int CTimeStretch::compress(const float* in, unsigned int len, float* out)
+{
+	assert(in != NULL);
+	assert(out != NULL);
+	assert(len >= TS_MIN_LENGTH);
+
+	// Skip one period from the start, the first window is matched against
+	// the window one period later
+	unsigned int period = findPeriod(in, in, true);
+
+	crossFade(in, in + period, out);
+	::memcpy(out + TS_WINDOW, in + period + TS_WINDOW, (len - period - TS_WINDOW) * sizeof(float));
+
+	return len - period;
+}
+
+// The shortest lag with close to the highest normalised cross correlation
+// between the window at a and the window at b offset by the lag, forwards or
+// backwards
+unsigned int CTimeStretch::findPeriod(const float* a, const float* b, bool forward)
+{
+	float aEnergy = 0.0F;
+	for (unsigned int i = 0U; i < TS_WINDOW; i++)
+		aEnergy += a[i] * a[i];
+
+	float scores[TS_MAX_PERIOD + 1U];
+	float bestScore = -2.0F;
+
+	for (unsigned int lag = TS_MIN_PERIOD; lag <= TS_MAX_PERIOD; lag++) {
+		const float* c = forward ? b + lag : b - lag;
+
+		float cross  = 0.0F;
+		float energy = 0.0F;
+		for (unsigned int i = 0U; i < TS_WINDOW; i++) {
+			cross  += a[i] * c[i];
+			energy += c[i] * c[i];
+		}
+
+		float norm  = ::sqrtf(aEnergy * energy);
+		scores[lag] = norm > 0.0F ? cross / norm : 0.0F;
+		if (scores[lag] > bestScore)
+			bestScore = scores[lag];
+	}
+
+	// Multiples of the pitch period match almost as well, take the shortest
+	for (unsigned int lag = TS_MIN_PERIOD; lag <= TS_MAX_PERIOD; lag++) {
+		if (scores[lag] >= (bestScore - TS_MATCH_TOLERANCE))
+			return lag;
+	}
+
+	return TS_MIN_PERIOD;
+}
+
+void CTimeStretch::crossFade(const float* from, const float* to, float* out)
+{
+	for (unsigned int i = 0U; i < TS_WINDOW; i++) {
+		float gain = float(i) / float(TS_WINDOW);
+		out[i] = from[i] * (1.0F - gain) + to[i] * gain;
+	}
+}
@@ -0,0 +1,49 @@
+/*
+ *   Copyright (C) 2022 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#if !defined(TIMESTRETCH_H)
+#define	TIMESTRETCH_H
+
+// Pitch periods searched for at the codec rate, 400Hz down to 50Hz
+const unsigned int TS_MIN_PERIOD = 20U;
+const unsigned int TS_MAX_PERIOD = 160U;
+
+// The length of the cross fade at the splice
+const unsigned int TS_WINDOW = 80U;
+
+// The shortest block that can be stretched or compressed
+const unsigned int TS_MIN_LENGTH = TS_MAX_PERIOD + TS_WINDOW;
+
+// WSOLA time scaling of a block of speech at the codec rate. A block is
+// lengthened or shortened by the one pitch period which gives the best
+// match, cross faded over TS_WINDOW samples so that there is no click. The
+// first sample of the output is always the first sample of the input.
+class CTimeStretch {
+public:
+	// Returns the new length, out must have room for len + TS_MAX_PERIOD samples
+	static unsigned int stretch(const float* in, unsigned int len, float* out);
+
+	// Returns the new length, out must have room for len samples
+	static unsigned int compress(const float* in, unsigned int len, float* out);
+
+private:
+	static unsigned int findPeriod(const float* a, const float* b, bool forward);
+	static void crossFade(const float* from, const float* to, float* out);
+};
+
+#endif
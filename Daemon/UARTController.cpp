@@ -288,3 +288,8 @@ void CUARTController::close()
 	m_fd = -1;
 }
 
+
+int CUARTController::getFD() const
+{
+	return m_fd;
+}
@@ -37,6 +37,8 @@ public:
 
 	virtual void close();
 
+	virtual int getFD() const;
+
 #if defined(__APPLE__)
 	virtual int setNonblock(bool nonblock);
 #endif
@@ -287,3 +287,11 @@ void CUDPSocket::close(const unsigned int index)
 	}
 }
 
+
+int CUDPSocket::getFD(const unsigned int index) const
+{
+	if (index >= UDP_SOCKET_MAX)
+		return -1;
+
+	return m_fd[index];
+}
@@ -0,0 +1,183 @@
+/*
+ *   Copyright (C) 2022 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include "WAVFileReader.h"
+#include "Log.h"
+
+#include <cassert>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+
+const uint16_t WAV_FORMAT_PCM   = 1U;
+const uint16_t WAV_FORMAT_FLOAT = 3U;
+
+const unsigned int WAV_MAX_CHANNELS = 8U;
+
+static uint16_t readLE16(const unsigned char* p)
+{
+	return (p[0U] << 0) | (p[1U] << 8);
+}
+
+static uint32_t readLE32(const unsigned char* p)
+{
+	return (p[0U] << 0) | (p[1U] << 8) | (p[2U] << 16) | (uint32_t(p[3U]) << 24);
+}
+
+CWAVFileReader::CWAVFileReader(const std::string& filename) :
+m_filename(filename),
+m_fp(NULL),
+m_sampleRate(0U),
+m_channels(0U),
+m_format(0U),
+m_bytes(0U),
+m_remaining(0U)
+{
+	assert(!filename.empty());
+}
+
+CWAVFileReader::~CWAVFileReader()
+{
+}
+
+bool CWAVFileReader::open()
+{
+	m_fp = ::fopen(m_filename.c_str(), "rb");
+	if (m_fp == NULL) {
+		LogError("Cannot open the WAV file - %s, errno=%d", m_filename.c_str(), errno);
+		return false;
+	}
+
+	unsigned char header[12U];
+	if (::fread(header, 1U, 12U, m_fp) != 12U || ::memcmp(header + 0U, "RIFF", 4U) != 0 || ::memcmp(header + 8U, "WAVE", 4U) != 0) {
+		LogError("%s is not a WAV file", m_filename.c_str());
+		close();
+		return false;
+	}
+
+	// Walk the chunks until the data, the fmt chunk must come before it
+	for (;;) {
+		unsigned char chunk[8U];
+		if (::fread(chunk, 1U, 8U, m_fp) != 8U) {
+			LogError("No data found in the WAV file - %s", m_filename.c_str());
+			close();
+			return false;
+		}
+
+		uint32_t length = readLE32(chunk + 4U);
+
+		if (::memcmp(chunk, "fmt ", 4U) == 0) {
+			unsigned char fmt[16U];
+			if (length < 16U || ::fread(fmt, 1U, 16U, m_fp) != 16U) {
+				LogError("Invalid format in the WAV file - %s", m_filename.c_str());
+				close();
+				return false;
+			}
+
+			m_format     = readLE16(fmt + 0U);
+			m_channels   = readLE16(fmt + 2U);
+			m_sampleRate = readLE32(fmt + 4U);
+			m_bytes      = readLE16(fmt + 14U) / 8U;
+
+			length -= 16U;
+		} else if (::memcmp(chunk, "data", 4U) == 0) {
+			if (m_channels == 0U) {
+				LogError("Invalid format in the WAV file - %s", m_filename.c_str());
+				close();
+				return false;
+			}
+
+			m_remaining = length;
+			break;
+		}
+
+		// Chunks are padded to an even length
+		if (::fseek(m_fp, long(length + (length & 1U)), SEEK_CUR) != 0) {
+			LogError("Error reading the WAV file - %s", m_filename.c_str());
+			close();
+			return false;
+		}
+	}
+
+	if (!((m_format == WAV_FORMAT_PCM && m_bytes == 2U) || (m_format == WAV_FORMAT_FLOAT && m_bytes == 4U))) {
+		LogError("Only 16-bit PCM and 32-bit float WAV files are supported - %s", m_filename.c_str());
+		close();
+		return false;
+	}
+
+	if (m_channels > WAV_MAX_CHANNELS) {
+		LogError("Only up to %u channels are supported - %s", WAV_MAX_CHANNELS, m_filename.c_str());
+		close();
+		return false;
+	}
+
+	return true;
+}
+
+unsigned int CWAVFileReader::getSampleRate() const
+{
+	return m_sampleRate;
+}
+
+unsigned int CWAVFileReader::getChannels() const
+{
+	return m_channels;
+}
+
+unsigned int CWAVFileReader::read(float* audio, unsigned int len)
+{
+	assert(m_fp != NULL);
+	assert(audio != NULL);
+
+	unsigned int frameSize = m_bytes * m_channels;
+
+	unsigned int n = 0U;
+	while (n < len && m_remaining >= frameSize) {
+		unsigned char frame[WAV_MAX_CHANNELS * 4U];
+		if (::fread(frame, 1U, frameSize, m_fp) != frameSize) {
+			m_remaining = 0U;
+			break;
+		}
+
+		m_remaining -= frameSize;
+
+		float sample = 0.0F;
+		for (unsigned int i = 0U; i < m_channels; i++) {
+			if (m_format == WAV_FORMAT_PCM) {
+				sample += float(int16_t(readLE16(frame + i * 2U))) / 32768.0F;
+			} else {
+				uint32_t bits = readLE32(frame + i * 4U);
+				float f;
+				::memcpy(&f, &bits, sizeof(float));
+				sample += f;
+			}
+		}
+
+		audio[n++] = sample / float(m_channels);
+	}
+
+	return n;
+}
+
+void CWAVFileReader::close()
+{
+	if (m_fp != NULL) {
+		::fclose(m_fp);
+		m_fp = NULL;
+	}
+}
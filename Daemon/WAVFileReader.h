@@ -0,0 +1,52 @@
+/*
+ *   Copyright (C) 2022 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#if !defined(WAVFILEREADER_H)
+#define	WAVFILEREADER_H
+
+#include <string>
+
+#include <cstdio>
+
+// Reads 16-bit PCM and 32-bit float WAV files, multiple channels are mixed
+// down to mono
+class CWAVFileReader {
+public:
+	CWAVFileReader(const std::string& filename);
+	~CWAVFileReader();
+
+	bool open();
+
+	unsigned int getSampleRate() const;
+	unsigned int getChannels() const;
+
+	unsigned int read(float* audio, unsigned int len);
+
+	void close();
+
+private:
+	std::string  m_filename;
+	FILE*        m_fp;
+	unsigned int m_sampleRate;
+	unsigned int m_channels;
+	unsigned int m_format;
+	unsigned int m_bytes;
+	unsigned int m_remaining;
+};
+
+#endif
@@ -0,0 +1,154 @@
+/*
+ *   Copyright (C) 2022 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include "WAVFileWriter.h"
+#include "Log.h"
+
+#include <cassert>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+
+const unsigned int WAV_HEADER_LENGTH = 44U;
+
+static void writeLE16(unsigned char* p, uint16_t n)
+{
+	p[0U] = (n >> 0) & 0xFFU;
+	p[1U] = (n >> 8) & 0xFFU;
+}
+
+static void writeLE32(unsigned char* p, uint32_t n)
+{
+	p[0U] = (n >> 0)  & 0xFFU;
+	p[1U] = (n >> 8)  & 0xFFU;
+	p[2U] = (n >> 16) & 0xFFU;
+	p[3U] = (n >> 24) & 0xFFU;
+}
+
+CWAVFileWriter::CWAVFileWriter(const std::string& filename, unsigned int sampleRate, unsigned int channels) :
+m_filename(filename),
+m_sampleRate(sampleRate),
+m_channels(channels),
+m_fp(NULL),
+m_samples(0U)
+{
+	assert(!filename.empty());
+	assert(sampleRate > 0U);
+	assert(channels > 0U);
+}
+
+CWAVFileWriter::~CWAVFileWriter()
+{
+}
+
+bool CWAVFileWriter::open()
+{
+	m_fp = ::fopen(m_filename.c_str(), "wb");
+	if (m_fp == NULL) {
+		LogError("Cannot open the WAV file - %s, errno=%d", m_filename.c_str(), errno);
+		return false;
+	}
+
+	m_samples = 0U;
+
+	// A placeholder until the length is known
+	return writeHeader();
+}
+
+bool CWAVFileWriter::write(const float* audio, unsigned int len)
+{
+	assert(m_fp != NULL);
+	assert(audio != NULL);
+
+	if (len == 0U)
+		return true;
+
+	unsigned char buffer[2U * 960U];
+
+	while (len > 0U) {
+		unsigned int n = (len > 960U) ? 960U : len;
+
+		for (unsigned int i = 0U; i < n; i++) {
+			float sample = audio[i];
+			if (sample > 1.0F)
+				sample = 1.0F;
+			else if (sample < -1.0F)
+				sample = -1.0F;
+
+			writeLE16(buffer + i * 2U, uint16_t(int16_t(sample * 32767.0F)));
+		}
+
+		if (::fwrite(buffer, 2U, n, m_fp) != n) {
+			LogError("Error writing to the WAV file - %s, errno=%d", m_filename.c_str(), errno);
+			return false;
+		}
+
+		m_samples += n;
+		audio     += n;
+		len       -= n;
+	}
+
+	return true;
+}
+
+unsigned int CWAVFileWriter::getSamples() const
+{
+	return m_samples / m_channels;
+}
+
+void CWAVFileWriter::close()
+{
+	assert(m_fp != NULL);
+
+	::fseek(m_fp, 0L, SEEK_SET);
+	writeHeader();
+
+	::fclose(m_fp);
+	m_fp = NULL;
+}
+
+bool CWAVFileWriter::writeHeader()
+{
+	assert(m_fp != NULL);
+
+	uint32_t dataLength = m_samples * 2U;
+
+	unsigned char header[WAV_HEADER_LENGTH];
+	::memcpy(header + 0U, "RIFF", 4U);
+	writeLE32(header + 4U, dataLength + WAV_HEADER_LENGTH - 8U);
+	::memcpy(header + 8U, "WAVE", 4U);
+
+	::memcpy(header + 12U, "fmt ", 4U);
+	writeLE32(header + 16U, 16U);							// Length of the fmt chunk
+	writeLE16(header + 20U, 1U);							// PCM
+	writeLE16(header + 22U, m_channels);
+	writeLE32(header + 24U, m_sampleRate);
+	writeLE32(header + 28U, m_sampleRate * m_channels * 2U);	// Bytes per second
+	writeLE16(header + 32U, m_channels * 2U);				// Block align
+	writeLE16(header + 34U, 16U);							// Bits per sample
+
+	::memcpy(header + 36U, "data", 4U);
+	writeLE32(header + 40U, dataLength);
+
+	if (::fwrite(header, 1U, WAV_HEADER_LENGTH, m_fp) != WAV_HEADER_LENGTH) {
+		LogError("Error writing to the WAV file - %s, errno=%d", m_filename.c_str(), errno);
+		return false;
+	}
+
+	return true;
+}
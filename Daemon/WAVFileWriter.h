@@ -0,0 +1,51 @@
+/*
+ *   Copyright (C) 2022 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#if !defined(WAVFILEWRITER_H)
+#define	WAVFILEWRITER_H
+
+#include <string>
+
+#include <cstdio>
+
+// Writes 16-bit PCM WAV files, the lengths in the header are filled in by
+// close()
+class CWAVFileWriter {
+public:
+	CWAVFileWriter(const std::string& filename, unsigned int sampleRate, unsigned int channels = 1U);
+	~CWAVFileWriter();
+
+	bool open();
+
+	bool write(const float* audio, unsigned int len);
+
+	unsigned int getSamples() const;
+
+	void close();
+
+private:
+	std::string  m_filename;
+	unsigned int m_sampleRate;
+	unsigned int m_channels;
+	FILE*        m_fp;
+	unsigned int m_samples;
+
+	bool writeHeader();
+};
+
+#endif
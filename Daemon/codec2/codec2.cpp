@@ -65,11 +65,10 @@ CKissFFT kiss;
   AUTHOR......: David Rowe
   DATE CREATED: 21/8/2010
 
-  Create and initialise an instance of the codec.  Returns a pointer
-  to the codec states or NULL on failure.  One set of states is
-  sufficient for a full duuplex codec (i.e. an encoder and decoder).
-  You don't need separate states for encoders and decoders.  See
-  c2enc.c and c2dec.c for examples.
+  Create and initialise an instance of the codec.  The state that is
+  fixed once created is shared, the encoder and the decoder each own
+  their own running state so that they may be used from different
+  threads.
 
 \*---------------------------------------------------------------------------*/
 
@@ -81,76 +80,66 @@ CCodec2::CCodec2(bool is_3200)
 
 	c2.c2const = c2const_create(8000, N_S);
 	c2.Fs = c2.c2const.Fs;
-	int n_samp = c2.n_samp = c2.c2const.n_samp;
-	int m_pitch = c2.m_pitch = c2.c2const.m_pitch;
-
-	c2.Pn.resize(2*n_samp);
-	c2.Sn_.resize(2*n_samp);
-	c2.w.resize(m_pitch);
-	c2.Sn.resize(m_pitch);
+	c2.n_samp = c2.c2const.n_samp;
+	c2.m_pitch = c2.c2const.m_pitch;
+}
 
-	for(int i=0; i<m_pitch; i++)
-		c2.Sn[i] = 1.0;
-	c2.hpf_states[0] = c2.hpf_states[1] = 0.0;
-	for(int i=0; i<2*n_samp; i++)
-		c2.Sn_[i] = 0;
-	kiss.fft_alloc(c2.fft_fwd_cfg, FFT_ENC, false);
-	kiss.fftr_alloc(c2.fftr_fwd_cfg, FFT_ENC, false);
-	make_analysis_window(&c2.c2const, &c2.fft_fwd_cfg, c2.w.data(), c2.W);
-	make_synthesis_window(&c2.c2const, c2.Pn.data());
-	kiss.fftr_alloc(c2.fftr_inv_cfg, FFT_DEC, true);
-	c2.prev_f0_enc = 1/P_MAX_S;
-	c2.bg_est = 0.0;
-	c2.ex_phase = 0.0;
+CCodec2Encoder::CCodec2Encoder(bool is_3200) :
+CCodec2(is_3200)
+{
+	int m_pitch = c2.m_pitch;
 
-	for(int l=1; l<=MAX_AMP; l++)
-		c2.prev_model_dec.A[l] = 0.0;
-	c2.prev_model_dec.Wo = TWO_PI/c2.c2const.p_max;
-	c2.prev_model_dec.L = PI/c2.prev_model_dec.Wo;
-	c2.prev_model_dec.voiced = 0;
+	enc.w.resize(m_pitch);
+	enc.Sn.resize(m_pitch);
 
-	for(int i=0; i<LPC_ORD; i++)
-	{
-		c2.prev_lsps_dec[i] = i*PI/(LPC_ORD+1);
-	}
-	c2.prev_e_dec = 1;
+	for(int i=0; i<m_pitch; i++)
+		enc.Sn[i] = 1.0;
+	kiss.fft_alloc(enc.fft_fwd_cfg, FFT_ENC, false);
+	make_analysis_window(&c2.c2const, &enc.fft_fwd_cfg, enc.w.data(), enc.W);
+	enc.prev_f0_enc = 1/P_MAX_S;
 
 	nlp.nlp_create(&c2.c2const);
 
-	c2.lpc_pf = 1;
-	c2.bass_boost = 1;
-	c2.beta = LPCPF_BETA;
-	c2.gamma = LPCPF_GAMMA;
+	codec2_set_mode(is_3200);
+}
 
-	c2.xq_enc[0] = c2.xq_enc[1] = 0.0;
-	c2.xq_dec[0] = c2.xq_dec[1] = 0.0;
+CCodec2Decoder::CCodec2Decoder(bool is_3200) :
+CCodec2(is_3200)
+{
+	int n_samp = c2.n_samp;
 
-	c2.smoothing = 0;
+	dec.Pn.resize(2*n_samp);
+	dec.Sn_.resize(2*n_samp);
 
-	c2.bpf_buf.resize(BPF_N+4*c2.n_samp);
-	for(int i=0; i<BPF_N+4*c2.n_samp; i++)
-		c2.bpf_buf[i] = 0.0;
+	for(int i=0; i<2*n_samp; i++)
+		dec.Sn_[i] = 0;
+	kiss.fftr_alloc(dec.fftr_fwd_cfg, FFT_ENC, false);
+	make_synthesis_window(&c2.c2const, dec.Pn.data());
+	kiss.fftr_alloc(dec.fftr_inv_cfg, FFT_DEC, true);
+	dec.bg_est = 0.0;
+	dec.ex_phase = 0.0;
+
+	for(int l=1; l<=MAX_AMP; l++)
+		dec.prev_model_dec.A[l] = 0.0;
+	dec.prev_model_dec.Wo = TWO_PI/c2.c2const.p_max;
+	dec.prev_model_dec.L = PI/dec.prev_model_dec.Wo;
+	dec.prev_model_dec.voiced = 0;
 
-	c2.softdec = NULL;
-	c2.gray = 1;
+	for(int i=0; i<LPC_ORD; i++)
+	{
+		dec.prev_lsps_dec[i] = i*PI/(LPC_ORD+1);
+	}
+	dec.prev_e_dec = 1;
 
-	// make sure that one of the two decode function pointers is empty
-	// for the encode function pointer this is not required since we always set it
-	// to a meaningful value
+	dec.lpc_pf = 1;
+	dec.bass_boost = 1;
+	dec.beta = LPCPF_BETA;
+	dec.gamma = LPCPF_GAMMA;
 
-	decode = NULL;
 	m_decode_gain = 1.0f;
+	m_rand_next = 1;
 
-	if ( 3200 == c2.mode)
-	{
-		encode = &CCodec2::codec2_encode_3200;
-		decode = &CCodec2::codec2_decode_3200;
-	}
-	else
-	{
-		encode = &CCodec2::codec2_encode_1600;
-		decode = &CCodec2::codec2_decode_1600;
-	}
+	codec2_set_mode(is_3200);
 }
 
 /*---------------------------------------------------------------------------*\
@@ -165,32 +154,44 @@ CCodec2::CCodec2(bool is_3200)
 
 CCodec2::~CCodec2()
 {
-	c2.bpf_buf.clear();
+}
+
+CCodec2Encoder::~CCodec2Encoder()
+{
 	nlp.nlp_destroy();
-	c2.fft_fwd_cfg.twiddles.clear();
-	c2.fftr_fwd_cfg.substate.twiddles.clear();
-	c2.fftr_fwd_cfg.tmpbuf.clear();
-	c2.fftr_fwd_cfg.super_twiddles.clear();
-	c2.fftr_inv_cfg.substate.twiddles.clear();
-	c2.fftr_inv_cfg.tmpbuf.clear();
-	c2.fftr_inv_cfg.super_twiddles.clear();
-	c2.Pn.clear();
-	c2.Sn.clear();
-	c2.w.clear();
-	c2.Sn_.clear();
+	enc.fft_fwd_cfg.twiddles.clear();
+	enc.Sn.clear();
+	enc.w.clear();
+}
+
+CCodec2Decoder::~CCodec2Decoder()
+{
+	dec.fftr_fwd_cfg.substate.twiddles.clear();
+	dec.fftr_fwd_cfg.tmpbuf.clear();
+	dec.fftr_fwd_cfg.super_twiddles.clear();
+	dec.fftr_inv_cfg.substate.twiddles.clear();
+	dec.fftr_inv_cfg.tmpbuf.clear();
+	dec.fftr_inv_cfg.super_twiddles.clear();
+	dec.Pn.clear();
+	dec.Sn_.clear();
 }
 
-void CCodec2::codec2_set_mode(bool m)
+void CCodec2Encoder::codec2_set_mode(bool m)
 {
 	c2.mode = m ? 3200 : 1600;
-	if (c2.mode == 3200){
-		encode = &CCodec2::codec2_encode_3200;
-		decode = &CCodec2::codec2_decode_3200;
-	}
-	else{
-		encode = &CCodec2::codec2_encode_1600;
-		decode = &CCodec2::codec2_decode_1600;
-	}
+	if (c2.mode == 3200)
+		encode = &CCodec2Encoder::codec2_encode_3200;
+	else
+		encode = &CCodec2Encoder::codec2_encode_1600;
+}
+
+void CCodec2Decoder::codec2_set_mode(bool m)
+{
+	c2.mode = m ? 3200 : 1600;
+	if (c2.mode == 3200)
+		decode = &CCodec2Decoder::codec2_decode_3200;
+	else
+		decode = &CCodec2Decoder::codec2_decode_1600;
 }
 
 /*---------------------------------------------------------------------------*\
@@ -228,18 +229,80 @@ int CCodec2::codec2_samples_per_frame()
 	return 0; /* shouldnt get here */
 }
 
-void CCodec2::codec2_encode(unsigned char *bits, const short *speech)
+void CCodec2Encoder::codec2_encode(unsigned char *bits, const short *speech)
 {
 	assert(encode != NULL);
 
-	(*this.*encode)(bits, speech);
+	float in[320];
+	int n = codec2_samples_per_frame();
+	for (int i=0; i<n; i++)
+		in[i] = speech[i];
+
+	(*this.*encode)(bits, in);
+}
+
+void CCodec2Encoder::codec2_encode(unsigned char *bits, const float *speech, float gain)
+{
+	assert(encode != NULL);
+
+	float in[320];
+	int n = codec2_samples_per_frame();
+	for (int i=0; i<n; i++)
+	{
+		float x = speech[i] * gain;
+		if (x > 32767.0)
+			in[i] = 32767.0;
+		else if (x < -32767.0)
+			in[i] = -32767.0;
+		else
+			in[i] = x;
+	}
+
+	(*this.*encode)(bits, in);
+}
+
+/* the float samples are already clipped to the range of a short */
+static void codec2_to_short(short speech[], const float in[], int n)
+{
+	for (int i=0; i<n; i++)
+		speech[i] = in[i];
 }
 
-void CCodec2::codec2_decode(short *speech, const unsigned char *bits)
+void CCodec2Decoder::codec2_decode(short *speech, const unsigned char *bits)
 {
 	assert(decode != NULL);
 
-	(*this.*decode)(speech, bits);
+	float out[320];
+	(*this.*decode)(out, bits);
+
+	codec2_to_short(speech, out, codec2_samples_per_frame());
+}
+
+void CCodec2Decoder::codec2_decode(float *speech, const unsigned char *bits, unsigned int frames, float gain)
+{
+	assert(decode != NULL);
+
+	int n = codec2_samples_per_frame();
+	int nbytes = (codec2_bits_per_frame() + 7) / 8;
+
+	for (unsigned int i=0; i<frames; i++)
+	{
+		float *out = speech + i*n;
+		(*this.*decode)(out, bits + i*nbytes);
+
+		for (int j=0; j<n; j++)
+			out[j] *= gain;
+	}
+}
+
+void CCodec2Decoder::codec2_decode(CCodec2Decoder *decoders[], float *speech[], const unsigned char *bits[], unsigned int streams, float gain)
+{
+	assert(decoders != NULL);
+	assert(speech != NULL);
+	assert(bits != NULL);
+
+	for (unsigned int i=0; i<streams; i++)
+		decoders[i]->codec2_decode(speech[i], bits[i], 1U, gain);
 }
 
 
@@ -269,7 +332,7 @@ void CCodec2::codec2_decode(short *speech, const unsigned char *bits)
 
 \*---------------------------------------------------------------------------*/
 
-void CCodec2::codec2_encode_3200(unsigned char *bits, const short *speech)
+void CCodec2Encoder::codec2_encode_3200(unsigned char *bits, const float *speech)
 {
 	MODEL   model;
 	float   ak[LPC_ORD+1];
@@ -294,7 +357,7 @@ void CCodec2::codec2_encode_3200(unsigned char *bits, const short *speech)
 	Wo_index = qt.encode_Wo(&c2.c2const, model.Wo, WO_BITS);
 	qt.pack(bits, &nbit, Wo_index, WO_BITS);
 
-	e = qt.speech_to_uq_lsps(lsps, ak, c2.Sn.data(), c2.w.data(), c2.m_pitch, LPC_ORD);
+	e = qt.speech_to_uq_lsps(lsps, ak, enc.Sn.data(), enc.w.data(), c2.m_pitch, LPC_ORD);
 	e_index = qt.encode_energy(e, E_BITS);
 	qt.pack(bits, &nbit, e_index, E_BITS);
 
@@ -317,7 +380,7 @@ void CCodec2::codec2_encode_3200(unsigned char *bits, const short *speech)
 
 \*---------------------------------------------------------------------------*/
 
-void CCodec2::codec2_decode_3200(short speech[], const unsigned char * bits)
+void CCodec2Decoder::codec2_decode_3200(float speech[], const unsigned char * bits)
 {
 	MODEL   model[2];
 	int     lspd_indexes[LPC_ORD];
@@ -362,28 +425,28 @@ void CCodec2::codec2_decode_3200(short speech[], const unsigned char * bits)
 	/* Wo and energy are sampled every 20ms, so we interpolate just 1
 	   10ms frame between 20ms samples */
 
-	interp_Wo(&model[0], &c2.prev_model_dec, &model[1], c2.c2const.Wo_min);
-	e[0] = interp_energy(c2.prev_e_dec, e[1]);
+	interp_Wo(&model[0], &dec.prev_model_dec, &model[1], c2.c2const.Wo_min);
+	e[0] = interp_energy(dec.prev_e_dec, e[1]);
 
 	/* LSPs are sampled every 20ms so we interpolate the frame in
 	   between, then recover spectral amplitudes */
 
-	interpolate_lsp_ver2(&lsps[0][0], c2.prev_lsps_dec, &lsps[1][0], 0.5, LPC_ORD);
+	interpolate_lsp_ver2(&lsps[0][0], dec.prev_lsps_dec, &lsps[1][0], 0.5, LPC_ORD);
 
 	for(i=0; i<2; i++)
 	{
 		lsp_to_lpc(&lsps[i][0], &ak[i][0], LPC_ORD);
-		qt.aks_to_M2(&(c2.fftr_fwd_cfg), &ak[i][0], LPC_ORD, &model[i], e[i], &snr, 0, c2.lpc_pf, c2.bass_boost, c2.beta, c2.gamma, Aw);
+		qt.aks_to_M2(&(dec.fftr_fwd_cfg), &ak[i][0], LPC_ORD, &model[i], e[i], &snr, 0, dec.lpc_pf, dec.bass_boost, dec.beta, dec.gamma, Aw);
 		qt.apply_lpc_correction(&model[i]);
 		synthesise_one_frame(&speech[c2.n_samp*i], &model[i], Aw, m_decode_gain);
 	}
 
 	/* update memories for next frame ----------------------------*/
 
-	c2.prev_model_dec = model[1];
-	c2.prev_e_dec = e[1];
+	dec.prev_model_dec = model[1];
+	dec.prev_e_dec = e[1];
 	for(i=0; i<LPC_ORD; i++)
-		c2.prev_lsps_dec[i] = lsps[1][i];
+		dec.prev_lsps_dec[i] = lsps[1][i];
 }
 
 /*---------------------------------------------------------------------------*\
@@ -414,7 +477,7 @@ void CCodec2::codec2_decode_3200(short speech[], const unsigned char * bits)
 
 \*---------------------------------------------------------------------------*/
 
-void CCodec2::codec2_encode_1600(unsigned char * bits, const short speech[])
+void CCodec2Encoder::codec2_encode_1600(unsigned char * bits, const float speech[])
 {
 	MODEL   model;
 	float   lsps[LPC_ORD];
@@ -441,7 +504,7 @@ void CCodec2::codec2_encode_1600(unsigned char * bits, const short speech[])
 	qt.pack(bits, &nbit, Wo_index, WO_BITS);
 
 	/* need to run this just to get LPC energy */
-	e = qt.speech_to_uq_lsps(lsps, ak, c2.Sn.data(), c2.w.data(), c2.m_pitch, LPC_ORD);
+	e = qt.speech_to_uq_lsps(lsps, ak, enc.Sn.data(), enc.w.data(), c2.m_pitch, LPC_ORD);
 	e_index = qt.encode_energy(e, E_BITS);
 	qt.pack(bits, &nbit, e_index, E_BITS);
 
@@ -458,7 +521,7 @@ void CCodec2::codec2_encode_1600(unsigned char * bits, const short speech[])
 	Wo_index = qt.encode_Wo(&c2.c2const, model.Wo, WO_BITS);
 	qt.pack(bits, &nbit, Wo_index, WO_BITS);
 
-	e = qt.speech_to_uq_lsps(lsps, ak, c2.Sn.data(), c2.w.data(), c2.m_pitch, LPC_ORD);
+	e = qt.speech_to_uq_lsps(lsps, ak, enc.Sn.data(), enc.w.data(), c2.m_pitch, LPC_ORD);
 	e_index = qt.encode_energy(e, E_BITS);
 	qt.pack(bits, &nbit, e_index, E_BITS);
 
@@ -482,7 +545,7 @@ void CCodec2::codec2_encode_1600(unsigned char * bits, const short speech[])
 
 \*---------------------------------------------------------------------------*/
 
-void CCodec2::codec2_decode_1600(short speech[], const unsigned char * bits)
+void CCodec2Decoder::codec2_decode_1600(float speech[], const unsigned char * bits)
 {
 	MODEL   model[4];
 	int     lsp_indexes[LPC_ORD];
@@ -540,8 +603,8 @@ void CCodec2::codec2_decode_1600(short speech[], const unsigned char * bits)
 	/* Wo and energy are sampled every 20ms, so we interpolate just 1
 	   10ms frame between 20ms samples */
 
-	interp_Wo(&model[0], &c2.prev_model_dec, &model[1], c2.c2const.Wo_min);
-	e[0] = interp_energy(c2.prev_e_dec, e[1]);
+	interp_Wo(&model[0], &dec.prev_model_dec, &model[1], c2.c2const.Wo_min);
+	e[0] = interp_energy(dec.prev_e_dec, e[1]);
 	interp_Wo(&model[2], &model[1], &model[3], c2.c2const.Wo_min);
 	e[2] = interp_energy(e[1], e[3]);
 
@@ -550,23 +613,73 @@ void CCodec2::codec2_decode_1600(short speech[], const unsigned char * bits)
 
 	for(i=0, weight=0.25; i<3; i++, weight += 0.25)
 	{
-		interpolate_lsp_ver2(&lsps[i][0], c2.prev_lsps_dec, &lsps[3][0], weight, LPC_ORD);
+		interpolate_lsp_ver2(&lsps[i][0], dec.prev_lsps_dec, &lsps[3][0], weight, LPC_ORD);
 	}
 	for(i=0; i<4; i++)
 	{
 		lsp_to_lpc(&lsps[i][0], &ak[i][0], LPC_ORD);
-		qt.aks_to_M2(&(c2.fftr_fwd_cfg), &ak[i][0], LPC_ORD, &model[i], e[i], &snr, 0, c2.lpc_pf, c2.bass_boost, c2.beta, c2.gamma, Aw);
+		qt.aks_to_M2(&(dec.fftr_fwd_cfg), &ak[i][0], LPC_ORD, &model[i], e[i], &snr, 0, dec.lpc_pf, dec.bass_boost, dec.beta, dec.gamma, Aw);
 		qt.apply_lpc_correction(&model[i]);
 		synthesise_one_frame(&speech[c2.n_samp*i], &model[i], Aw, m_decode_gain);
 	}
 
 	/* update memories for next frame ----------------------------*/
 
-	c2.prev_model_dec = model[3];
-	c2.prev_e_dec = e[3];
+	dec.prev_model_dec = model[3];
+	dec.prev_e_dec = e[3];
 	for(i=0; i<LPC_ORD; i++)
-		c2.prev_lsps_dec[i] = lsps[3][i];
+		dec.prev_lsps_dec[i] = lsps[3][i];
+
+}
+
+/*---------------------------------------------------------------------------*\
+
+  FUNCTION....: conceal_one_frame
+
+  Synthesises one frame of speech in place of a lost or corrupted one
+  by repeating the last decoded model, pitch, voicing and LSPs, with
+  its amplitude scaled by fade. The energy memory is updated so that
+  repeated calls with a fade below one fade out, and so that the next
+  good frame interpolates from the concealed level.
+
+\*---------------------------------------------------------------------------*/
+
+void CCodec2Decoder::conceal_one_frame(float speech[], float fade)
+{
+	MODEL   model;
+	float   ak[LPC_ORD+1];
+	float   e;
+	float   snr;
+	int     i,j;
+	std::complex<float>    Aw[FFT_ENC];
+
+	/* energy is a power, the fade an amplitude */
+
+	e = dec.prev_e_dec * fade * fade;
+
+	lsp_to_lpc(dec.prev_lsps_dec, ak, LPC_ORD);
+
+	for(i=0; i<codec2_samples_per_frame()/c2.n_samp; i++)
+	{
+		model = dec.prev_model_dec;
+		for(j=1; j<=MAX_AMP; j++)
+			model.A[j] = 0.0;
+
+		qt.aks_to_M2(&(dec.fftr_fwd_cfg), ak, LPC_ORD, &model, e, &snr, 0, dec.lpc_pf, dec.bass_boost, dec.beta, dec.gamma, Aw);
+		qt.apply_lpc_correction(&model);
+		synthesise_one_frame(&speech[c2.n_samp*i], &model, Aw, m_decode_gain);
+	}
+
+	dec.prev_e_dec = e;
+}
+
+void CCodec2Decoder::codec2_conceal(float *speech, float fade, float gain)
+{
+	conceal_one_frame(speech, fade);
 
+	int n = codec2_samples_per_frame();
+	for (int i=0; i<n; i++)
+		speech[i] *= gain;
 }
 
 /*---------------------------------------------------------------------------* \
@@ -579,33 +692,33 @@ void CCodec2::codec2_decode_1600(short speech[], const unsigned char * bits)
 
 \*---------------------------------------------------------------------------*/
 
-void CCodec2::synthesise_one_frame(short speech[], MODEL *model, std::complex<float> Aw[], float gain)
+void CCodec2Decoder::synthesise_one_frame(float speech[], MODEL *model, std::complex<float> Aw[], float gain)
 {
 	int     i;
 
 	/* LPC based phase synthesis */
 	std::complex<float> H[MAX_AMP+1];
 	sample_phase(model, H, Aw);
-	phase_synth_zero_order(c2.n_samp, model, &c2.ex_phase, H);
+	phase_synth_zero_order(c2.n_samp, model, &dec.ex_phase, H);
 
-	postfilter(model, &c2.bg_est);
-	synthesise(c2.n_samp, &(c2.fftr_inv_cfg), c2.Sn_.data(), model, c2.Pn.data(), 1);
+	postfilter(model, &dec.bg_est);
+	synthesise(c2.n_samp, &(dec.fftr_inv_cfg), dec.Sn_.data(), model, dec.Pn.data(), 1);
 
 	for(i=0; i<c2.n_samp; i++)
 	{
-		c2.Sn_[i] *= gain;
+		dec.Sn_[i] *= gain;
 	}
 
-	ear_protection(c2.Sn_.data(), c2.n_samp);
+	ear_protection(dec.Sn_.data(), c2.n_samp);
 
 	for(i=0; i<c2.n_samp; i++)
 	{
-		if (c2.Sn_[i] > 32767.0)
-			speech[i] = 32767;
-		else if (c2.Sn_[i] < -32767.0)
-			speech[i] = -32767;
+		if (dec.Sn_[i] > 32767.0)
+			speech[i] = 32767.0;
+		else if (dec.Sn_[i] < -32767.0)
+			speech[i] = -32767.0;
 		else
-			speech[i] = c2.Sn_[i];
+			speech[i] = dec.Sn_[i];
 	}
 }
 
@@ -621,7 +734,7 @@ void CCodec2::synthesise_one_frame(short speech[], MODEL *model, std::complex<fl
 
 \*---------------------------------------------------------------------------*/
 
-void CCodec2::analyse_one_frame(MODEL *model, const short *speech)
+void CCodec2Encoder::analyse_one_frame(MODEL *model, const float *speech)
 {
 	std::complex<float>    Sw[FFT_ENC];
 	float   pitch;
@@ -632,14 +745,14 @@ void CCodec2::analyse_one_frame(MODEL *model, const short *speech)
 	/* Read input speech */
 
 	for(i=0; i<m_pitch-n_samp; i++)
-		c2.Sn[i] = c2.Sn[i+n_samp];
+		enc.Sn[i] = enc.Sn[i+n_samp];
 	for(i=0; i<n_samp; i++)
-		c2.Sn[i+m_pitch-n_samp] = speech[i];
+		enc.Sn[i+m_pitch-n_samp] = speech[i];
 
-	dft_speech(&c2.c2const, c2.fft_fwd_cfg, Sw, c2.Sn.data(), c2.w.data());
+	dft_speech(&c2.c2const, enc.fft_fwd_cfg, Sw, enc.Sn.data(), enc.w.data());
 
 	/* Estimate pitch */
-	nlp.nlp(c2.Sn.data(), n_samp, &pitch, &c2.prev_f0_enc);
+	nlp.nlp(enc.Sn.data(), n_samp, &pitch, &enc.prev_f0_enc);
 	model->Wo = TWO_PI/pitch;
 	model->L = PI/model->Wo;
 
@@ -648,7 +761,7 @@ void CCodec2::analyse_one_frame(MODEL *model, const short *speech)
 
 	/* estimate phases when doing ML experiments */
 	estimate_amplitudes(model, Sw, 0);
-	est_voicing_mbe(&c2.c2const, model, Sw, c2.W);
+	est_voicing_mbe(&c2.c2const, model, Sw, enc.W);
 }
 
 
@@ -812,7 +925,7 @@ void CCodec2::sample_phase(MODEL *model,
 
 \*---------------------------------------------------------------------------*/
 
-void CCodec2::phase_synth_zero_order(
+void CCodec2Decoder::phase_synth_zero_order(
 	int    n_samp,
 	MODEL *model,
 	float *ex_phase,            /* excitation phase of fundamental        */
@@ -923,7 +1036,7 @@ void CCodec2::phase_synth_zero_order(
 			            // spikey (impulsive) for mmt1, but speech was
                         // perhaps a little rougher.
 
-void CCodec2::postfilter( MODEL *model, float *bg_est )
+void CCodec2Decoder::postfilter( MODEL *model, float *bg_est )
 {
 	int   m, uv;
 	float e, thresh;
@@ -1119,7 +1232,7 @@ void CCodec2::make_analysis_window(C2CONST *c2const, FFT_STATE *fft_fwd_cfg, flo
 
 \*---------------------------------------------------------------------------*/
 
-void CCodec2::dft_speech(C2CONST *c2const, FFT_STATE &fft_fwd_cfg, std::complex<float> Sw[], float Sn[], float w[])
+void CCodec2Encoder::dft_speech(C2CONST *c2const, FFT_STATE &fft_fwd_cfg, std::complex<float> Sw[], float Sn[], float w[])
 {
     int  i;
     int  m_pitch = c2const->m_pitch;
@@ -1525,11 +1638,10 @@ void CCodec2::synthesise(
 			Sn_[i] += sw_[j]*Pn[i];
 }
 
-int CCodec2::codec2_rand(void)
+int CCodec2Decoder::codec2_rand(void)
 {
-	static unsigned long next = 1;
-	next = next * 1103515245 + 12345;
-	return((unsigned)(next/65536) % 32768);
+	m_rand_next = m_rand_next * 1103515245 + 12345;
+	return((unsigned)(m_rand_next/65536) % 32768);
 }
 
 /*---------------------------------------------------------------------------*\
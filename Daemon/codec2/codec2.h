@@ -46,35 +46,30 @@
 
 #define CODEC2_RAND_MAX 32767
 
+// The state that is fixed once created and the stateless analysis and
+// synthesis functions, shared by the encoder and the decoder
 class CCodec2
 {
 public:
-	CCodec2(bool is_3200);
-	~CCodec2();
-	void codec2_encode(unsigned char *bits, const short *speech_in);
-	void codec2_decode(short *speech_out, const unsigned char *bits);
-	void codec2_set_mode(bool);
 	bool codec2_get_mode() {return (c2.mode == 3200); };
 	int  codec2_samples_per_frame();
 	int  codec2_bits_per_frame();
-	void set_decode_gain(float g){ m_decode_gain = g; }
 
-private:
+protected:
+	CCodec2(bool is_3200);
+	~CCodec2();
+
 	// merged from other files
 	void sample_phase(MODEL *model, std::complex<float> filter_phase[], std::complex<float> A[]);
-	void phase_synth_zero_order(int n_samp, MODEL *model, float *ex_phase, std::complex<float> filter_phase[]);
-	void postfilter(MODEL *model, float *bg_est);
 
 	C2CONST c2const_create(int Fs, float framelength_ms);
 
 	void make_analysis_window(C2CONST *c2const, FFT_STATE *fft_fwd_cfg, float w[], float W[]);
-	void dft_speech(C2CONST *c2const, FFT_STATE &fft_fwd_cfg, std::complex<float> Sw[], float Sn[], float w[]);
 	void two_stage_pitch_refinement(C2CONST *c2const, MODEL *model, std::complex<float> Sw[]);
 	void estimate_amplitudes(MODEL *model, std::complex<float> Sw[], int est_phase);
 	float est_voicing_mbe(C2CONST *c2const, MODEL *model, std::complex<float> Sw[], float W[]);
 	void make_synthesis_window(C2CONST *c2const, float Pn[]);
 	void synthesise(int n_samp, FFTR_STATE *fftr_inv_cfg, float Sn_[], MODEL *model, float Pn[], int shift);
-	int codec2_rand(void);
 	void hs_pitch_refinement(MODEL *model, std::complex<float> Sw[], float pmin, float pmax, float pstep);
 
 	void interp_Wo(MODEL *interp, MODEL *prev, MODEL *next, float Wo_min);
@@ -82,21 +77,67 @@ private:
 	float interp_energy(float prev, float next);
 	void interpolate_lsp_ver2(float interp[], float prev[],  float next[], float weight, int order);
 
-	void analyse_one_frame(MODEL *model, const short *speech);
-	void synthesise_one_frame(short speech[], MODEL *model, std::complex<float> Aw[], float gain);
-	void codec2_encode_3200(unsigned char *bits, const short *speech);
-	void codec2_encode_1600(unsigned char *bits, const short *speech);
-	void codec2_decode_3200(short *speech, const unsigned char *bits);
-	void codec2_decode_1600(short *speech, const unsigned char *bits);
 	void ear_protection(float in_out[], int n);
 	void lsp_to_lpc(float *freq, float *ak, int lpcrdr);
 
-	void (CCodec2::*encode)(unsigned char *bits, const short *speech);
-	void (CCodec2::*decode)(short *speech, const unsigned char *bits);
-	Cnlp nlp;
 	CQuantize qt;
 	CODEC2 c2;
+};
+
+// The encoder and the decoder own separate state, so an encoder and a
+// decoder may be used from different threads at the same time
+class CCodec2Encoder : public CCodec2
+{
+public:
+	CCodec2Encoder(bool is_3200);
+	~CCodec2Encoder();
+	void codec2_encode(unsigned char *bits, const short *speech_in);
+	// From floats scaled by gain, so 32768 takes +-1.0 to full scale, and
+	// clipped to the range of a short
+	void codec2_encode(unsigned char *bits, const float *speech_in, float gain);
+	void codec2_set_mode(bool);
+
+private:
+	void dft_speech(C2CONST *c2const, FFT_STATE &fft_fwd_cfg, std::complex<float> Sw[], float Sn[], float w[]);
+	void analyse_one_frame(MODEL *model, const float *speech);
+	void codec2_encode_3200(unsigned char *bits, const float *speech);
+	void codec2_encode_1600(unsigned char *bits, const float *speech);
+
+	void (CCodec2Encoder::*encode)(unsigned char *bits, const float *speech);
+	Cnlp nlp;
+	CODEC2_ENC enc;
+};
+
+class CCodec2Decoder : public CCodec2
+{
+public:
+	CCodec2Decoder(bool is_3200);
+	~CCodec2Decoder();
+	void codec2_decode(short *speech_out, const unsigned char *bits);
+	// A number of frames packed back to back in bits, each giving
+	// codec2_samples_per_frame() samples as floats scaled by gain, so 1/32768
+	// gives +-1.0 full scale
+	void codec2_decode(float *speech_out, const unsigned char *bits, unsigned int frames, float gain);
+	// One frame from each of a number of independent streams in lockstep,
+	// the output for each stream goes to its own buffer
+	static void codec2_decode(CCodec2Decoder *decoders[], float *speech_out[], const unsigned char *bits[], unsigned int streams, float gain);
+	void codec2_conceal(float *speech_out, float fade, float gain);
+	void codec2_set_mode(bool);
+	void set_decode_gain(float g){ m_decode_gain = g; }
+
+private:
+	void phase_synth_zero_order(int n_samp, MODEL *model, float *ex_phase, std::complex<float> filter_phase[]);
+	void postfilter(MODEL *model, float *bg_est);
+	void synthesise_one_frame(float speech[], MODEL *model, std::complex<float> Aw[], float gain);
+	int codec2_rand(void);
+	void codec2_decode_3200(float *speech, const unsigned char *bits);
+	void codec2_decode_1600(float *speech, const unsigned char *bits);
+	void conceal_one_frame(float speech[], float fade);
+
+	void (CCodec2Decoder::*decode)(float *speech, const unsigned char *bits);
+	CODEC2_DEC dec;
 	float m_decode_gain;
+	unsigned long m_rand_next;
 };
 
 #endif
@@ -0,0 +1,402 @@
+/*
+ *   Copyright (C) 2022 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#if !defined(CODEC2_FFT_H)
+#define	CODEC2_FFT_H
+
+#include <complex>
+#include <utility>
+#include <cassert>
+#include <cmath>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+// Four lanes of the split real or imaginary parts
+#if defined(__SSE2__)
+typedef __m128 FFT_VEC;
+
+static inline FFT_VEC fftLoad(const float* p)          { return _mm_loadu_ps(p); }
+static inline void    fftStore(float* p, FFT_VEC a)    { _mm_storeu_ps(p, a); }
+static inline FFT_VEC fftDup(float a)                  { return _mm_set1_ps(a); }
+static inline FFT_VEC fftAdd(FFT_VEC a, FFT_VEC b)     { return _mm_add_ps(a, b); }
+static inline FFT_VEC fftSub(FFT_VEC a, FFT_VEC b)     { return _mm_sub_ps(a, b); }
+static inline FFT_VEC fftMul(FFT_VEC a, FFT_VEC b)     { return _mm_mul_ps(a, b); }
+
+// Stores a[0] b[0] c[0] d[0] a[1] b[1] ... to p
+static inline void fftStore4(float* p, FFT_VEC a, FFT_VEC b, FFT_VEC c, FFT_VEC d)
+{
+	_MM_TRANSPOSE4_PS(a, b, c, d);
+	_mm_storeu_ps(p + 0U,  a);
+	_mm_storeu_ps(p + 4U,  b);
+	_mm_storeu_ps(p + 8U,  c);
+	_mm_storeu_ps(p + 12U, d);
+}
+#elif defined(__ARM_NEON)
+typedef float32x4_t FFT_VEC;
+
+static inline FFT_VEC fftLoad(const float* p)          { return vld1q_f32(p); }
+static inline void    fftStore(float* p, FFT_VEC a)    { vst1q_f32(p, a); }
+static inline FFT_VEC fftDup(float a)                  { return vdupq_n_f32(a); }
+static inline FFT_VEC fftAdd(FFT_VEC a, FFT_VEC b)     { return vaddq_f32(a, b); }
+static inline FFT_VEC fftSub(FFT_VEC a, FFT_VEC b)     { return vsubq_f32(a, b); }
+static inline FFT_VEC fftMul(FFT_VEC a, FFT_VEC b)     { return vmulq_f32(a, b); }
+
+static inline void fftStore4(float* p, FFT_VEC a, FFT_VEC b, FFT_VEC c, FFT_VEC d)
+{
+	float32x4x4_t v = { { a, b, c, d } };
+	vst4q_f32(p, v);
+}
+#else
+struct FFT_VEC {
+	float v[4U];
+};
+
+static inline FFT_VEC fftLoad(const float* p)          { FFT_VEC r; for (unsigned int i = 0U; i < 4U; i++) r.v[i] = p[i]; return r; }
+static inline void    fftStore(float* p, FFT_VEC a)    { for (unsigned int i = 0U; i < 4U; i++) p[i] = a.v[i]; }
+static inline FFT_VEC fftDup(float a)                  { FFT_VEC r; for (unsigned int i = 0U; i < 4U; i++) r.v[i] = a; return r; }
+static inline FFT_VEC fftAdd(FFT_VEC a, FFT_VEC b)     { FFT_VEC r; for (unsigned int i = 0U; i < 4U; i++) r.v[i] = a.v[i] + b.v[i]; return r; }
+static inline FFT_VEC fftSub(FFT_VEC a, FFT_VEC b)     { FFT_VEC r; for (unsigned int i = 0U; i < 4U; i++) r.v[i] = a.v[i] - b.v[i]; return r; }
+static inline FFT_VEC fftMul(FFT_VEC a, FFT_VEC b)     { FFT_VEC r; for (unsigned int i = 0U; i < 4U; i++) r.v[i] = a.v[i] * b.v[i]; return r; }
+
+static inline void fftStore4(float* p, FFT_VEC a, FFT_VEC b, FFT_VEC c, FFT_VEC d)
+{
+	for (unsigned int i = 0U; i < 4U; i++) {
+		p[i * 4U + 0U] = a.v[i];
+		p[i * 4U + 1U] = b.v[i];
+		p[i * 4U + 2U] = c.v[i];
+		p[i * 4U + 3U] = d.v[i];
+	}
+}
+#endif
+
+// A complex FFT of a fixed power of two size, unscaled in both directions
+// as kiss_fft is. It is a Stockham autosort FFT, radix-4 stages with a
+// final radix-2 stage when needed, so there is no bit reversal pass. The
+// data is held as separate real and imaginary arrays so that four points
+// go through each butterfly at a time, with the twiddles for each stage
+// precomputed in the same layout.
+template <unsigned int N, bool INVERSE>
+class CFFT {
+public:
+	static_assert(N >= 16U && (N & (N - 1U)) == 0U, "The FFT size must be a power of two of at least 16");
+
+	static void fft(const std::complex<float>* in, std::complex<float>* out)
+	{
+		assert(in != NULL);
+		assert(out != NULL);
+
+		float xr[N], xi[N], yr[N], yi[N];
+
+		for (unsigned int i = 0U; i < N; i++) {
+			xr[i] = in[i].real();
+			xi[i] = in[i].imag();
+		}
+
+		const float* re;
+		const float* im;
+		fft(xr, xi, yr, yi, re, im);
+
+		for (unsigned int i = 0U; i < N; i++)
+			out[i] = std::complex<float>(re[i], im[i]);
+	}
+
+	// Transforms the split data in xr and xi, using yr and yi as well, and
+	// sets re and im to whichever pair holds the result
+	static void fft(float* xr, float* xi, float* yr, float* yi, const float*& re, const float*& im)
+	{
+		const CTwiddles& tw = twiddles();
+
+		unsigned int n = N;
+		unsigned int s = 1U;
+		const float* w = tw.m_w;
+
+		while (n >= 4U) {
+			radix4(n, s, w, xr, xi, yr, yi);
+
+			w += 6U * (n / 4U);
+			n /= 4U;
+			s *= 4U;
+
+			std::swap(xr, yr);
+			std::swap(xi, yi);
+		}
+
+		if (n == 2U) {
+			radix2(s, xr, xi, yr, yi);
+
+			std::swap(xr, yr);
+			std::swap(xi, yi);
+		}
+
+		re = xr;
+		im = xi;
+	}
+
+private:
+	// For each radix-4 stage of length n, w1, w2 and w3 for p = 0 to n/4-1,
+	// real parts then imaginary parts
+	struct CTwiddles {
+		CTwiddles()
+		{
+			const double sign = INVERSE ? 1.0 : -1.0;
+
+			float* w = m_w;
+			for (unsigned int n = N; n >= 4U; n /= 4U) {
+				const unsigned int n4 = n / 4U;
+
+				for (unsigned int p = 0U; p < n4; p++) {
+					for (unsigned int k = 1U; k <= 3U; k++) {
+						double phase = sign * 2.0 * M_PI * double(k * p) / double(n);
+						w[(2U * k - 2U) * n4 + p] = float(::cos(phase));
+						w[(2U * k - 1U) * n4 + p] = float(::sin(phase));
+					}
+				}
+
+				w += 6U * n4;
+			}
+		}
+
+		// 6 * (N/4 + N/16 + ...) is less than 2N
+		float m_w[2U * N];
+	};
+
+	static const CTwiddles& twiddles()
+	{
+		static const CTwiddles tw;
+		return tw;
+	}
+
+	// Multiply by j going forward and by -j going back
+	static inline void rotate(FFT_VEC& re, FFT_VEC& im, FFT_VEC r, FFT_VEC i)
+	{
+		if (INVERSE) {
+			re = i;
+			im = fftSub(fftDup(0.0F), r);
+		} else {
+			re = fftSub(fftDup(0.0F), i);
+			im = r;
+		}
+	}
+
+	static inline void butterfly(FFT_VEC ar, FFT_VEC ai, FFT_VEC br, FFT_VEC bi, FFT_VEC cr, FFT_VEC ci, FFT_VEC dr, FFT_VEC di,
+				     FFT_VEC w1r, FFT_VEC w1i, FFT_VEC w2r, FFT_VEC w2i, FFT_VEC w3r, FFT_VEC w3i,
+				     FFT_VEC* yr, FFT_VEC* yi)
+	{
+		FFT_VEC apcr = fftAdd(ar, cr), apci = fftAdd(ai, ci);
+		FFT_VEC amcr = fftSub(ar, cr), amci = fftSub(ai, ci);
+		FFT_VEC bpdr = fftAdd(br, dr), bpdi = fftAdd(bi, di);
+
+		FFT_VEC jbmdr, jbmdi;
+		rotate(jbmdr, jbmdi, fftSub(br, dr), fftSub(bi, di));
+
+		yr[0U] = fftAdd(apcr, bpdr);
+		yi[0U] = fftAdd(apci, bpdi);
+
+		FFT_VEC t1r = fftSub(amcr, jbmdr), t1i = fftSub(amci, jbmdi);
+		FFT_VEC t2r = fftSub(apcr, bpdr),  t2i = fftSub(apci, bpdi);
+		FFT_VEC t3r = fftAdd(amcr, jbmdr), t3i = fftAdd(amci, jbmdi);
+
+		yr[1U] = fftSub(fftMul(t1r, w1r), fftMul(t1i, w1i));
+		yi[1U] = fftAdd(fftMul(t1r, w1i), fftMul(t1i, w1r));
+		yr[2U] = fftSub(fftMul(t2r, w2r), fftMul(t2i, w2i));
+		yi[2U] = fftAdd(fftMul(t2r, w2i), fftMul(t2i, w2r));
+		yr[3U] = fftSub(fftMul(t3r, w3r), fftMul(t3i, w3i));
+		yi[3U] = fftAdd(fftMul(t3r, w3i), fftMul(t3i, w3r));
+	}
+
+	static void radix4(unsigned int n, unsigned int s, const float* w, const float* xr, const float* xi, float* yr, float* yi)
+	{
+		const unsigned int n4 = n / 4U;
+
+		const float* w1r = w + 0U * n4;
+		const float* w1i = w + 1U * n4;
+		const float* w2r = w + 2U * n4;
+		const float* w2i = w + 3U * n4;
+		const float* w3r = w + 4U * n4;
+		const float* w3i = w + 5U * n4;
+
+		FFT_VEC outr[4U], outi[4U];
+
+		if (s == 1U) {
+			// The first stage, four values of p at a time, the outputs for
+			// each p are adjacent so they are transposed as they are stored
+			for (unsigned int p = 0U; p < n4; p += 4U) {
+				butterfly(fftLoad(xr + p), fftLoad(xi + p), fftLoad(xr + p + n4), fftLoad(xi + p + n4),
+					  fftLoad(xr + p + 2U * n4), fftLoad(xi + p + 2U * n4), fftLoad(xr + p + 3U * n4), fftLoad(xi + p + 3U * n4),
+					  fftLoad(w1r + p), fftLoad(w1i + p), fftLoad(w2r + p), fftLoad(w2i + p), fftLoad(w3r + p), fftLoad(w3i + p),
+					  outr, outi);
+
+				fftStore4(yr + 4U * p, outr[0U], outr[1U], outr[2U], outr[3U]);
+				fftStore4(yi + 4U * p, outi[0U], outi[1U], outi[2U], outi[3U]);
+			}
+		} else {
+			// Later stages, four values of q at a time
+			for (unsigned int p = 0U; p < n4; p++) {
+				FFT_VEC vw1r = fftDup(w1r[p]), vw1i = fftDup(w1i[p]);
+				FFT_VEC vw2r = fftDup(w2r[p]), vw2i = fftDup(w2i[p]);
+				FFT_VEC vw3r = fftDup(w3r[p]), vw3i = fftDup(w3i[p]);
+
+				const unsigned int in  = s * p;
+				const unsigned int out = s * 4U * p;
+
+				for (unsigned int q = 0U; q < s; q += 4U) {
+					butterfly(fftLoad(xr + q + in), fftLoad(xi + q + in), fftLoad(xr + q + in + s * n4), fftLoad(xi + q + in + s * n4),
+						  fftLoad(xr + q + in + 2U * s * n4), fftLoad(xi + q + in + 2U * s * n4), fftLoad(xr + q + in + 3U * s * n4), fftLoad(xi + q + in + 3U * s * n4),
+						  vw1r, vw1i, vw2r, vw2i, vw3r, vw3i,
+						  outr, outi);
+
+					for (unsigned int k = 0U; k < 4U; k++) {
+						fftStore(yr + q + out + k * s, outr[k]);
+						fftStore(yi + q + out + k * s, outi[k]);
+					}
+				}
+			}
+		}
+	}
+
+	// The last stage when N is an odd power of two, the twiddle is one
+	static void radix2(unsigned int s, const float* xr, const float* xi, float* yr, float* yi)
+	{
+		for (unsigned int q = 0U; q < s; q += 4U) {
+			FFT_VEC ar = fftLoad(xr + q),     ai = fftLoad(xi + q);
+			FFT_VEC br = fftLoad(xr + q + s), bi = fftLoad(xi + q + s);
+
+			fftStore(yr + q,     fftAdd(ar, br));
+			fftStore(yi + q,     fftAdd(ai, bi));
+			fftStore(yr + q + s, fftSub(ar, br));
+			fftStore(yi + q + s, fftSub(ai, bi));
+		}
+	}
+};
+
+// A real FFT of a fixed even size N, done as a packed complex FFT of size
+// N/2, the even samples in the real parts and the odd samples in the
+// imaginary parts, which the split layout gets for free. The forward
+// transform gives N/2+1 bins and the inverse takes them, unscaled as
+// kiss_fftr is.
+template <unsigned int N>
+class CRealFFT {
+public:
+	static void fft(const float* in, std::complex<float>* out)
+	{
+		assert(in != NULL);
+		assert(out != NULL);
+
+		const unsigned int H = N / 2U;
+
+		float xr[H], xi[H], yr[H], yi[H];
+		for (unsigned int i = 0U; i < H; i++) {
+			xr[i] = in[2U * i + 0U];
+			xi[i] = in[2U * i + 1U];
+		}
+
+		const float* zr;
+		const float* zi;
+		CFFT<H, false>::fft(xr, xi, yr, yi, zr, zi);
+
+		const CTwiddles& tw = twiddles(false);
+
+		out[0U] = std::complex<float>(zr[0U] + zi[0U], 0.0F);
+		out[H]  = std::complex<float>(zr[0U] - zi[0U], 0.0F);
+
+		for (unsigned int k = 1U; k <= H / 2U; k++) {
+			// Z[k] and the conjugate of Z[H-k] give the even and odd halves
+			float f1r = zr[k] + zr[H - k];
+			float f1i = zi[k] - zi[H - k];
+			float f2r = zr[k] - zr[H - k];
+			float f2i = zi[k] + zi[H - k];
+
+			float twr = f2r * tw.m_r[k] - f2i * tw.m_i[k];
+			float twi = f2r * tw.m_i[k] + f2i * tw.m_r[k];
+
+			out[k]     = std::complex<float>(0.5F * (f1r + twr), 0.5F * (f1i + twi));
+			out[H - k] = std::complex<float>(0.5F * (f1r - twr), 0.5F * (twi - f1i));
+		}
+	}
+
+	static void ifft(const std::complex<float>* in, float* out)
+	{
+		assert(in != NULL);
+		assert(out != NULL);
+
+		const unsigned int H = N / 2U;
+
+		const CTwiddles& tw = twiddles(true);
+
+		float xr[H], xi[H], yr[H], yi[H];
+
+		xr[0U] = in[0U].real() + in[H].real();
+		xi[0U] = in[0U].real() - in[H].real();
+
+		for (unsigned int k = 1U; k <= H / 2U; k++) {
+			float fer = in[k].real() + in[H - k].real();
+			float fei = in[k].imag() - in[H - k].imag();
+			float tr  = in[k].real() - in[H - k].real();
+			float ti  = in[k].imag() + in[H - k].imag();
+
+			float for_ = tr * tw.m_r[k] - ti * tw.m_i[k];
+			float foi  = tr * tw.m_i[k] + ti * tw.m_r[k];
+
+			xr[k]     = fer + for_;
+			xi[k]     = fei + foi;
+			xr[H - k] = fer - for_;
+			xi[H - k] = foi - fei;
+		}
+
+		const float* zr;
+		const float* zi;
+		CFFT<H, true>::fft(xr, xi, yr, yi, zr, zi);
+
+		for (unsigned int i = 0U; i < H; i++) {
+			out[2U * i + 0U] = zr[i];
+			out[2U * i + 1U] = zi[i];
+		}
+	}
+
+private:
+	// exp(-j.pi.(k/(N/2) + 1/2)) going forward, conjugated going back
+	struct CTwiddles {
+		CTwiddles(bool inverse)
+		{
+			for (unsigned int k = 0U; k <= N / 4U; k++) {
+				double phase = -M_PI * (double(k) / double(N / 2U) + 0.5);
+				if (inverse)
+					phase = -phase;
+
+				m_r[k] = float(::cos(phase));
+				m_i[k] = float(::sin(phase));
+			}
+		}
+
+		float m_r[N / 4U + 1U];
+		float m_i[N / 4U + 1U];
+	};
+
+	static const CTwiddles& twiddles(bool inverse)
+	{
+		static const CTwiddles fwd(false);
+		static const CTwiddles inv(true);
+		return inverse ? inv : fwd;
+	}
+};
+
+#endif
@@ -17,6 +17,7 @@ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
 
 #include "defines.h"
 #include "kiss_fft.h"
+#include "fft.h"
 
 void CKissFFT::kf_bfly2(std::complex<float> *Fout, const size_t fstride, FFT_STATE &st, int m)
 {
@@ -320,6 +321,22 @@ void CKissFFT::fft_alloc(FFT_STATE &state, const int nfft, bool inverse_fft)
 
 void CKissFFT::fft_stride(FFT_STATE &st, const std::complex<float> *fin, std::complex<float> *fout, int in_stride)
 {
+	/* the sizes that codec2 uses have their own engine, it works in place */
+	if (in_stride == 1)
+	{
+		switch (st.nfft)
+		{
+		case 512:
+			st.inverse ? CFFT<512U, true>::fft(fin, fout) : CFFT<512U, false>::fft(fin, fout);
+			return;
+		case 256:
+			st.inverse ? CFFT<256U, true>::fft(fin, fout) : CFFT<256U, false>::fft(fin, fout);
+			return;
+		default:
+			break;
+		}
+	}
+
 	if (fin == fout)
 	{
 		//NOTE: this is not really an in-place FFT algorithm.
@@ -378,6 +395,12 @@ void CKissFFT::fftr(FFTR_STATE &st, const float *timedata, std::complex<float> *
 
 	auto ncfft = st.substate.nfft;
 
+	if (ncfft == 256)
+	{
+		CRealFFT<512U>::fft(timedata, freqdata);
+		return;
+	}
+
 	/*perform the parallel fft of two real signals packed in real,imag*/
 	fft( st.substate, (const std::complex<float>*)timedata, st.tmpbuf.data());
 	/* The real part of the DC element of the frequency spectrum in st->tmpbuf
@@ -417,6 +440,12 @@ void CKissFFT::fftri(FFTR_STATE &st, const std::complex<float> *freqdata, float
 
 	auto ncfft = st.substate.nfft;
 
+	if (ncfft == 256)
+	{
+		CRealFFT<512U>::ifft(freqdata, timedata);
+		return;
+	}
+
 	st.tmpbuf[0].real(freqdata[0].real() + freqdata[ncfft].real());
 	st.tmpbuf[0].imag(freqdata[0].real() - freqdata[ncfft].real());
 
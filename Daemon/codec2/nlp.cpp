@@ -33,6 +33,12 @@
 #include "nlp.h"
 #include "kiss_fft.h"
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
 extern CKissFFT kiss;
 
 /*---------------------------------------------------------------------------*\
@@ -146,6 +152,52 @@ static const float fdmdv_os_filter[]= {
     -0.0008215855034550383
 };
 
+/*---------------------------------------------------------------------------*\
+
+  nlp_fir_filter()
+
+  Inner product of the NLP_NTAP samples in x[] with the low pass filter
+  coefficients, four taps at a time.
+
+\*---------------------------------------------------------------------------*/
+
+static inline float nlp_fir_filter(const float *x)
+{
+	static_assert((NLP_NTAP % 4) == 0, "NLP_NTAP must be a multiple of four");
+
+#if defined(__SSE2__)
+	__m128 sum = _mm_setzero_ps();
+	for (int j=0; j<NLP_NTAP; j+=4)
+		sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(x + j), _mm_loadu_ps(nlp_fir + j)));
+
+	__m128 shuf = _mm_shuffle_ps(sum, sum, _MM_SHUFFLE(2, 3, 0, 1));
+	sum  = _mm_add_ps(sum, shuf);
+	shuf = _mm_movehl_ps(shuf, sum);
+	sum  = _mm_add_ss(sum, shuf);
+
+	return _mm_cvtss_f32(sum);
+#elif defined(__ARM_NEON)
+	float32x4_t sum = vdupq_n_f32(0.0f);
+	for (int j=0; j<NLP_NTAP; j+=4)
+		sum = vmlaq_f32(sum, vld1q_f32(x + j), vld1q_f32(nlp_fir + j));
+
+	float32x2_t half = vadd_f32(vget_low_f32(sum), vget_high_f32(sum));
+
+	return vget_lane_f32(vpadd_f32(half, half), 0);
+#else
+	float sum0 = 0.0, sum1 = 0.0, sum2 = 0.0, sum3 = 0.0;
+	for (int j=0; j<NLP_NTAP; j+=4)
+	{
+		sum0 += x[j+0]*nlp_fir[j+0];
+		sum1 += x[j+1]*nlp_fir[j+1];
+		sum2 += x[j+2]*nlp_fir[j+2];
+		sum3 += x[j+3]*nlp_fir[j+3];
+	}
+
+	return (sum0 + sum1) + (sum2 + sum3);
+#endif
+}
+
 /*---------------------------------------------------------------------------*\
 
   nlp_create()
@@ -191,8 +243,9 @@ void Cnlp::nlp_create(C2CONST *c2const)
 		snlp.sq[i] = 0.0;
 	snlp.mem_x = 0.0;
 	snlp.mem_y = 0.0;
-	for(i=0; i<NLP_NTAP; i++)
+	for(i=0; i<2*NLP_NTAP; i++)
 		snlp.mem_fir[i] = 0.0;
+	snlp.fir_pos = 0;
 
 	kiss.fft_alloc(snlp.fft_cfg, PE_FFT_SIZE, false);
 }
@@ -299,13 +352,19 @@ float Cnlp::nlp(
 		assert(j <= n);
 	}
 
-	for(i=m-n; i<m; i++)  	/* notch filter at DC */
+	/* Only every DEC'th FIR output reaches the DFT. When the frame shift
+	   is a multiple of DEC a sample keeps its phase as it moves through
+	   sq[], so the others need never be computed. */
+
+	bool decimate = (n % DEC) == 0;
+
+	for(i=m-n; i<m; i++)  	/* notch filter at DC, and FIR filter */
 	{
 		notch = snlp.sq[i] - snlp.mem_x;
 		notch += COEFF*snlp.mem_y;
 		snlp.mem_x = snlp.sq[i];
 		snlp.mem_y = notch;
-		snlp.sq[i] = notch + 1.0;  /* With 0 input vectors to codec,
+		notch += 1.0;  /* With 0 input vectors to codec,
 				      kiss_fft() would take a long
 				      time to execute when running in
 				      real time.  Problem was traced
@@ -313,18 +372,18 @@ float Cnlp::nlp(
 				      this function. Adding this small
 				      constant fixed problem.  Not
 				      exactly sure why. */
-	}
 
-	for(i=m-n; i<m; i++)  	/* FIR filter vector */
-	{
+		/* the delay line is stored twice, so the latest NLP_NTAP
+		   samples are always contiguous from fir_pos */
 
-		for(j=0; j<NLP_NTAP-1; j++)
-			snlp.mem_fir[j] = snlp.mem_fir[j+1];
-		snlp.mem_fir[NLP_NTAP-1] = snlp.sq[i];
+		snlp.mem_fir[snlp.fir_pos] = notch;
+		snlp.mem_fir[snlp.fir_pos+NLP_NTAP] = notch;
+		snlp.fir_pos = (snlp.fir_pos + 1) % NLP_NTAP;
 
-		snlp.sq[i] = 0.0;
-		for(j=0; j<NLP_NTAP; j++)
-			snlp.sq[i] += snlp.mem_fir[j]*nlp_fir[j];
+		if (!decimate || (i % DEC) == 0)
+			snlp.sq[i] = nlp_fir_filter(&snlp.mem_fir[snlp.fir_pos]);
+		else
+			snlp.sq[i] = 0.0;
 	}
 
 	/* Decimate and DFT */
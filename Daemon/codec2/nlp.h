@@ -64,7 +64,8 @@ using NLP = struct nlp_tag
 	float         w[PMAX_M/DEC];     /* DFT window                   */
 	float         sq[PMAX_M];	     /* squared speech samples       */
 	float         mem_x,mem_y;       /* memory for notch filter      */
-	float         mem_fir[NLP_NTAP]; /* decimation FIR filter memory */
+	float         mem_fir[2*NLP_NTAP]; /* decimation FIR filter memory, stored twice */
+	int           fir_pos;           /* oldest sample in mem_fir[]   */
 	FFT_STATE     fft_cfg;           /* kiss FFT config              */
 	std::vector<float> Sn16k;	     /* Fs=16kHz input speech vector */
 };
@@ -3,6 +3,152 @@
 
 #include "qbase.h"
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#if defined(__SSE2__) || defined(__ARM_NEON)
+
+/*---------------------------------------------------------------------------*
+  vq_search
+
+  Finds the nearest of m codebook entries of dimension k, four entries at
+  a time, m must be a multiple of four. Each lane does the sums in the
+  same order as the scalar searches, and ties go to the lower index, so
+  the same index is chosen. With SQUARED the weights are applied as in
+  quantise(), otherwise as in find_nearest_weighted().
+
+\*---------------------------------------------------------------------------*/
+
+#if defined(__SSE2__)
+typedef __m128  VQ_FLOAT;
+typedef __m128i VQ_INDEX;
+
+/* element j of the four entries starting at cb */
+static inline VQ_FLOAT vq_gather(const float *cb, int k, int j)
+{
+	if (k == 1)
+		return _mm_loadu_ps(cb);
+
+	if (k == 2)
+	{
+		__m128 lo = _mm_loadu_ps(cb);
+		__m128 hi = _mm_loadu_ps(cb + 4);
+		return (j == 0) ? _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0)) : _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(3, 1, 3, 1));
+	}
+
+	return _mm_setr_ps(cb[j], cb[k + j], cb[2 * k + j], cb[3 * k + j]);
+}
+
+#define vq_dup(a)       _mm_set1_ps(a)
+#define vq_sub(a, b)    _mm_sub_ps(a, b)
+#define vq_mul(a, b)    _mm_mul_ps(a, b)
+#define vq_add(a, b)    _mm_add_ps(a, b)
+#define vq_index(i)     _mm_setr_epi32(i, i + 1, i + 2, i + 3)
+#define vq_store(p, a)  _mm_storeu_ps(p, a)
+#define vq_storei(p, a) _mm_storeu_si128((__m128i *)(p), a)
+
+static inline void vq_keep(VQ_FLOAT e, VQ_INDEX idx, VQ_FLOAT *beste, VQ_INDEX *besti)
+{
+	__m128  lt  = _mm_cmplt_ps(e, *beste);
+	__m128i lti = _mm_castps_si128(lt);
+
+	*beste = _mm_or_ps(_mm_and_ps(lt, e), _mm_andnot_ps(lt, *beste));
+	*besti = _mm_or_si128(_mm_and_si128(lti, idx), _mm_andnot_si128(lti, *besti));
+}
+#else
+typedef float32x4_t VQ_FLOAT;
+typedef int32x4_t   VQ_INDEX;
+
+static inline VQ_FLOAT vq_gather(const float *cb, int k, int j)
+{
+	if (k == 1)
+		return vld1q_f32(cb);
+
+	if (k == 2)
+		return (j == 0) ? vld2q_f32(cb).val[0] : vld2q_f32(cb).val[1];
+
+	float t[4] = { cb[j], cb[k + j], cb[2 * k + j], cb[3 * k + j] };
+	return vld1q_f32(t);
+}
+
+static inline VQ_INDEX vq_index(int i)
+{
+	int32_t t[4] = { i, i + 1, i + 2, i + 3 };
+	return vld1q_s32(t);
+}
+
+#define vq_dup(a)       vdupq_n_f32(a)
+#define vq_sub(a, b)    vsubq_f32(a, b)
+#define vq_mul(a, b)    vmulq_f32(a, b)
+#define vq_add(a, b)    vaddq_f32(a, b)
+#define vq_store(p, a)  vst1q_f32(p, a)
+#define vq_storei(p, a) vst1q_s32(p, a)
+
+static inline void vq_keep(VQ_FLOAT e, VQ_INDEX idx, VQ_FLOAT *beste, VQ_INDEX *besti)
+{
+	uint32x4_t lt = vcltq_f32(e, *beste);
+
+	*beste = vbslq_f32(lt, e, *beste);
+	*besti = vbslq_s32(lt, idx, *besti);
+}
+#endif
+
+template <bool SQUARED>
+static int vq_search(const float *cb, int m, const float *x, const float *w, int k, float init, float *beste)
+{
+	assert((m % 4) == 0);
+
+	VQ_FLOAT best  = vq_dup(init);
+	VQ_INDEX besti = vq_index(0);
+
+	for (int j = 0; j < m; j += 4)
+	{
+		VQ_FLOAT e = vq_dup(0.0f);
+		for (int i = 0; i < k; i++)
+		{
+			VQ_FLOAT c  = vq_gather(&cb[j * k], k, i);
+			VQ_FLOAT wi = vq_dup(w[i]);
+			if (SQUARED)
+			{
+				VQ_FLOAT diff = vq_sub(c, vq_dup(x[i]));
+				e = vq_add(e, vq_mul(vq_mul(vq_mul(diff, wi), diff), wi));
+			}
+			else
+			{
+				VQ_FLOAT diff = vq_sub(vq_dup(x[i]), c);
+				e = vq_add(e, vq_mul(vq_mul(wi, diff), diff));
+			}
+		}
+		vq_keep(e, vq_index(j), &best, &besti);
+	}
+
+	float   laneE[4];
+	int32_t laneI[4];
+	vq_store(laneE, best);
+	vq_storei(laneI, besti);
+
+	/* lanes that never beat the initial error still hold the first entries */
+	int nearest = 0;
+	float min = init;
+	for (int l = 0; l < 4; l++)
+	{
+		if (laneE[l] < min || (laneE[l] == min && laneE[l] < init && laneI[l] < nearest))
+		{
+			min = laneE[l];
+			nearest = laneI[l];
+		}
+	}
+
+	*beste = min;
+
+	return nearest;
+}
+
+#endif
+
 /*---------------------------------------------------------------------------*\
 
   quantise
@@ -28,6 +174,15 @@ long CQbase::quantise(const float *cb, float vec[], float w[], int k, int m, flo
 	int     i;
 	float   diff;
 
+#if defined(__SSE2__) || defined(__ARM_NEON)
+	if ((m % 4) == 0)
+	{
+		besti = vq_search<true>(cb, m, vec, w, k, 1E32, &beste);
+		*se += beste;
+		return(besti);
+	}
+#endif
+
 	besti = 0;
 	beste = 1E32;
 	for(j=0; j<m; j++)
@@ -183,6 +338,11 @@ int CQbase::find_nearest_weighted(const float *codebook, int nb_entries, float *
 	float min_dist = 1e15;
 	int nearest = 0;
 
+#if defined(__SSE2__) || defined(__ARM_NEON)
+	if ((nb_entries % 4) == 0)
+		return vq_search<false>(codebook, nb_entries, x, w, ndim, min_dist, &min_dist);
+#endif
+
 	for (i=0; i<nb_entries; i++)
 	{
 		float dist=0;
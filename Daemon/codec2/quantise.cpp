@@ -156,22 +156,13 @@ void CQuantize::compute_weights(const float *x, float *w, int ndim)
 
 int CQuantize::find_nearest(const float *codebook, int nb_entries, float *x, int ndim)
 {
-	int i, j;
-	float min_dist = 1e15;
-	int nearest = 0;
+	/* unit weights give exactly the same distances, and the vector search */
+	float w[LPC_ORD];
+	assert(ndim <= LPC_ORD);
+	for (int j=0; j<ndim; j++)
+		w[j] = 1.0;
 
-	for (i=0; i<nb_entries; i++)
-	{
-		float dist=0;
-		for (j=0; j<ndim; j++)
-			dist += (x[j]-codebook[i*ndim+j])*(x[j]-codebook[i*ndim+j]);
-		if (dist<min_dist)
-		{
-			min_dist = dist;
-			nearest = i;
-		}
-	}
-	return nearest;
+	return find_nearest_weighted(codebook, nb_entries, x, w, ndim);
 }
 
 int CQuantize::check_lsp_order(float lsp[], int order)